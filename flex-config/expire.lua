@@ -78,6 +78,13 @@ tables.boundaries = osm2pgsql.define_relation_table('boundaries', {
     { column = 'geom', type = 'multilinestring', not_null = true },
 })
 
+-- A table can also be defined with the `ephemeral = true` table option.
+-- Nothing is written to the database for such a table, it is only used for
+-- expiry. Because the old geometries are not stored, only tiles for new
+-- geometries are expired in append mode, not for the old geometries of
+-- changed or deleted objects. Ephemeral tables can not be partitioned, use
+-- `detect_changes`, indexes or derived columns.
+
 print("Tables:(")
 for name, ts in pairs(tables) do
     print("  " .. name .. ": name=" .. ts:name() .. " (" .. tostring(ts) .. ")")
@@ -325,6 +325,15 @@ options_t parse_command_line(int argc, char *argv[])
         ->description("Enable debug logging.")
         ->group("Logging options");
 
+    // --log-lua-profile
+    app.add_option("--log-lua-profile", options.lua_profile)
+        ->description("Log timings of the Lua code in the flex output at the "
+                      "end ('calls', or 'lines' to also sample Lua source "
+                      "lines).")
+        ->check(CLI::IsMember({"calls", "lines"}))
+        ->type_name("MODE")
+        ->group("Logging options");
+
     // ----------------------------------------------------------------------
     // Output options
     // ----------------------------------------------------------------------
@@ -571,6 +580,12 @@ options_t parse_command_line(int argc, char *argv[])
         ->type_name("NUM")
         ->group("Advanced options");
 
+    // --unlogged
+    app.add_flag("--unlogged", options.unlogged)
+        ->description("Create tables as UNLOGGED on import and set them to"
+                      " LOGGED at the end.")
+        ->group("Advanced options");
+
     // ----------------------------------------------------------------------
     // Tablespace options
     // ----------------------------------------------------------------------
@@ -624,6 +639,11 @@ options_t parse_command_line(int argc, char *argv[])
                                  "used at the same time!"};
     }
 
+    if (options.append && options.unlogged) {
+        log_warn("Ignoring option --unlogged. Can only be used on import.");
+        options.unlogged = false;
+    }
+
     check_options(&options);
 
     if (options.slim) { // slim mode, use database middle
@@ -632,6 +652,12 @@ options_t parse_command_line(int argc, char *argv[])
         check_options_non_slim(app);
     }
 
+    if (!options.lua_profile.empty() && options.output_backend != "flex") {
+        log_warn("Ignoring option --log-lua-profile. Can only be used with "
+                 "flex output.");
+        options.lua_profile.clear();
+    }
+
     if (options.output_backend == "flex") {
         check_options_output_flex(app);
     } else if (options.output_backend == "null") {
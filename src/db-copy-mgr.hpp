@@ -11,8 +11,12 @@
  */
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include "db-copy.hpp"
 #include "hex.hpp"
@@ -24,9 +28,17 @@ template <typename DELETER>
 class db_copy_mgr_t
 {
 public:
-    explicit db_copy_mgr_t(std::shared_ptr<db_copy_thread_t> processor)
-    : m_processor(std::move(processor))
-    {}
+    /**
+     * Create copy manager sending its data to the specified copy thread.
+     * Buffers are sent to the copy thread when they reach buffer_size.
+     */
+    explicit db_copy_mgr_t(
+        std::shared_ptr<db_copy_thread_t> processor,
+        std::size_t buffer_size = db_cmd_copy_t::MAX_BUF_SIZE)
+    : m_processor(std::move(processor)), m_buffer_size(buffer_size)
+    {
+        assert(m_buffer_size > 100);
+    }
 
     /**
      * Start a new table row.
@@ -40,17 +52,44 @@ public:
             if (m_current) {
                 m_processor->send_command(std::move(m_current));
             }
-            m_current = db_cmd_copy_delete_t<DELETER>(table);
+            m_current = db_cmd_copy_delete_t<DELETER>(table, m_buffer_size);
         }
         m_committed = m_current.buffer.size();
     }
 
+    /**
+     * Start a new table row in binary COPY format.
+     *
+     * Like new_line(), but also adds the number of columns in the row
+     * which starts each row in the binary format.
+     */
+    void new_binary_line(std::shared_ptr<db_target_descr_t> const &table)
+    {
+        assert(table->binary());
+        new_line(table);
+        add_binary_value(static_cast<int16_t>(table->num_binary_columns()));
+    }
+
+    /// Is the current row in binary COPY format?
+    bool binary() const noexcept
+    {
+        assert(m_current);
+        return m_current.target->binary();
+    }
+
     void rollback_line()
     {
         assert(m_current);
         m_current.buffer.resize(m_committed);
     }
 
+    /// The data added to the current (unfinished) row so far.
+    std::string_view current_line() const noexcept
+    {
+        assert(m_current);
+        return std::string_view{m_current.buffer}.substr(m_committed);
+    }
+
     /**
      * Finish a table row.
      *
@@ -65,9 +104,49 @@ public:
         assert(!buf.empty());
 
         // Expect that a column has been written last which ended in a '\t'.
-        // Replace it with the row delimiter '\n'.
-        assert(buf.back() == '\t');
-        buf.back() = '\n';
+        // Replace it with the row delimiter '\n'. The binary format doesn't
+        // have row delimiters.
+        if (!binary()) {
+            assert(buf.back() == '\t');
+            buf.back() = '\n';
+        }
+
+        if (m_current.is_full()) {
+            m_processor->send_command(std::move(m_current));
+            m_current = {};
+        }
+    }
+
+    /**
+     * Finish a table row like finish_line(), but instead of keeping the row
+     * in the buffer for sending it to the database, move it into *row.
+     * This is used when rows are collected and reordered before sending.
+     */
+    void take_line(std::string *row)
+    {
+        assert(m_current);
+
+        auto &buf = m_current.buffer;
+        assert(buf.size() > m_committed);
+        if (!binary()) {
+            assert(buf.back() == '\t');
+            buf.back() = '\n';
+        }
+
+        row->assign(buf, m_committed, std::string::npos);
+        buf.resize(m_committed);
+    }
+
+    /**
+     * Add a complete table row as returned by take_line().
+     *
+     * If the buffer is at capacity it will be forwarded to the copy thread.
+     */
+    void add_line(std::shared_ptr<db_target_descr_t> const &table,
+                  std::string_view row)
+    {
+        new_line(table);
+        m_current.buffer.append(row);
 
         if (m_current.is_full()) {
             m_processor->send_command(std::move(m_current));
@@ -241,6 +320,82 @@ public:
         m_current.buffer += '\t';
     }
 
+    /**
+     * Add a NULL column in binary COPY format.
+     */
+    void add_binary_null_column() { add_binary_value(int32_t{-1}); }
+
+    /**
+     * Add a column of simple type in binary COPY format.
+     *
+     * The type of the value must match the type of the database column
+     * exactly, for instance int16_t for an int2 column or float for a real
+     * column.
+     */
+    template <typename T,
+              std::enable_if_t<std::is_arithmetic_v<T>, bool> = true>
+    void add_binary_column(T value)
+    {
+        add_binary_value(static_cast<int32_t>(sizeof(T)));
+        add_binary_value(value);
+    }
+
+    /**
+     * Add a column with the data as is in binary COPY format. This is used
+     * for text, json, and geometry columns, the latter expect the geometry
+     * in (E)WKB format.
+     */
+    void add_binary_column(std::string_view data)
+    {
+        add_binary_value(static_cast<int32_t>(data.size()));
+        m_current.buffer.append(data);
+    }
+
+    /**
+     * Add a jsonb column in binary COPY format. The data must contain JSON
+     * in text form.
+     */
+    void add_binary_jsonb_column(std::string_view json)
+    {
+        // jsonb in binary format is the text preceded by a version number.
+        add_binary_value(static_cast<int32_t>(json.size() + 1));
+        m_current.buffer += '\1';
+        m_current.buffer.append(json);
+    }
+
+    /**
+     * Start a hstore column in binary COPY format.
+     *
+     * Must be closed with a finish_binary_hash() call.
+     */
+    void new_binary_hash()
+    {
+        m_hash_start = m_current.buffer.size();
+        m_hash_count = 0;
+        // Placeholders for the length of the column and number of pairs.
+        add_binary_value(int32_t{0});
+        add_binary_value(int32_t{0});
+    }
+
+    /// Add a key/value pair to a hstore column in binary COPY format.
+    void add_binary_hash_elem(std::string_view key, std::string_view value)
+    {
+        add_binary_value(static_cast<int32_t>(key.size()));
+        m_current.buffer.append(key);
+        add_binary_value(static_cast<int32_t>(value.size()));
+        m_current.buffer.append(value);
+        ++m_hash_count;
+    }
+
+    /// Close a hash previously started with new_binary_hash().
+    void finish_binary_hash()
+    {
+        auto const length = m_current.buffer.size() - m_hash_start -
+                            sizeof(int32_t);
+        set_binary_value(m_hash_start, static_cast<int32_t>(length));
+        set_binary_value(m_hash_start + sizeof(int32_t), m_hash_count);
+    }
+
     /**
      * Mark an OSM object for deletion in the current table.
      *
@@ -254,6 +409,21 @@ public:
         m_current.add_deletable(std::forward<ARGS>(args)...);
     }
 
+    /// Are there objects marked for deletion which have not been sent yet?
+    bool has_pending_deletes() const noexcept
+    {
+        return m_current && m_current.has_deletables();
+    }
+
+    /**
+     * Is the buffer at capacity, i.e. will it be forwarded to the copy
+     * thread when the current row is finished?
+     */
+    bool buffer_full() const noexcept
+    {
+        return m_current && m_current.is_full();
+    }
+
     void flush()
     {
         // flush current buffer if there is one
@@ -277,6 +447,43 @@ public:
     }
 
 private:
+    /**
+     * Convert a value into network byte order (big endian) as needed by
+     * the binary COPY format.
+     */
+    template <typename T>
+    static void to_network_order(T value, char *out) noexcept
+    {
+        using uint_type = std::conditional_t<
+            sizeof(T) == 1, uint8_t,
+            std::conditional_t<
+                sizeof(T) == 2, uint16_t,
+                std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+        static_assert(sizeof(uint_type) == sizeof(T));
+
+        uint_type bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        for (std::size_t i = sizeof(T); i > 0; --i) {
+            out[i - 1] = static_cast<char>(bits & 0xffU);
+            bits >>= 8U;
+        }
+    }
+
+    template <typename T>
+    void add_binary_value(T value)
+    {
+        char data[sizeof(T)];
+        to_network_order(value, data);
+        m_current.buffer.append(data, sizeof(T));
+    }
+
+    template <typename T>
+    void set_binary_value(std::size_t pos, T value)
+    {
+        assert(pos + sizeof(T) <= m_current.buffer.size());
+        to_network_order(value, &m_current.buffer[pos]);
+    }
+
     template <typename T>
     void add_value(T value)
     {
@@ -339,8 +546,15 @@ private:
     }
 
     std::shared_ptr<db_copy_thread_t> m_processor;
+    std::size_t m_buffer_size;
     db_cmd_copy_delete_t<DELETER> m_current;
     std::size_t m_committed = 0;
+
+    /// Start of hstore column currently written in binary COPY format.
+    std::size_t m_hash_start = 0;
+
+    /// Number of pairs in hstore column currently written in binary format.
+    int32_t m_hash_count = 0;
 };
 
 #endif // OSM2PGSQL_DB_COPY_MGR_HPP
@@ -17,6 +17,25 @@
 #include <cstdlib>
 #include <iterator>
 #include <stdexcept>
+#include <string_view>
+
+namespace {
+
+/**
+ * Header of data in binary COPY format: Signature, flags field, and length
+ * of (empty) header extension area.
+ * See https://www.postgresql.org/docs/current/sql-copy.html#id-1.9.3.55.9.4
+ */
+constexpr std::string_view const BINARY_COPY_HEADER{
+    "PGCOPY\n\377\r\n\0"
+    "\0\0\0\0"
+    "\0\0\0\0",
+    19};
+
+/// File trailer of data in binary COPY format: A field count of -1.
+constexpr std::string_view const BINARY_COPY_TRAILER{"\377\377", 2};
+
+} // anonymous namespace
 
 void db_deleter_by_id_t::delete_rows(std::string const &table,
                                      std::string const &column,
@@ -210,7 +229,7 @@ void db_copy_thread_t::thread_t::start_copy(
 
     auto const qname = qualified_name(target->schema(), target->name());
     fmt::memory_buffer sql;
-    sql.reserve(qname.size() + target->rows().size() + 20);
+    sql.reserve(qname.size() + target->rows().size() + 40);
     if (target->rows().empty()) {
         fmt::format_to(std::back_inserter(sql),
                        FMT_STRING("COPY {} FROM STDIN"), qname);
@@ -220,15 +239,27 @@ void db_copy_thread_t::thread_t::start_copy(
                        target->rows());
     }
 
+    if (target->binary()) {
+        fmt::format_to(std::back_inserter(sql), " (FORMAT BINARY)");
+    }
+
     sql.push_back('\0');
     m_db_connection.copy_start(to_string(sql));
 
+    if (target->binary()) {
+        m_db_connection.copy_send(BINARY_COPY_HEADER, target->name());
+    }
+
     m_inflight = target;
 }
 
 void db_copy_thread_t::thread_t::finish_copy()
 {
     if (m_inflight) {
+        if (m_inflight->binary()) {
+            m_db_connection.copy_send(BINARY_COPY_TRAILER,
+                                      m_inflight->name());
+        }
         m_db_connection.copy_end(m_inflight->name());
         m_inflight.reset();
     }
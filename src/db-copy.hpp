@@ -17,6 +17,7 @@
 #include <cassert>
 #include <cstddef>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <future>
 #include <memory>
@@ -49,6 +50,25 @@ public:
 
     void set_rows(std::string rows) { m_rows = std::move(rows); }
 
+    /// Is the data for this target in the binary COPY format?
+    bool binary() const noexcept { return m_num_binary_columns > 0; }
+
+    /// Number of columns in each row (only used for binary COPY format).
+    uint16_t num_binary_columns() const noexcept
+    {
+        return m_num_binary_columns;
+    }
+
+    /**
+     * Use the binary COPY format instead of the text format for this target.
+     * Every row must contain exactly num_columns columns.
+     */
+    void set_binary(uint16_t num_columns) noexcept
+    {
+        assert(num_columns > 0);
+        m_num_binary_columns = num_columns;
+    }
+
     /**
      * Check if the buffer would use exactly the same copy operation.
      */
@@ -56,7 +76,8 @@ public:
     {
         return (this == &other) ||
                (m_schema == other.m_schema && m_name == other.m_name &&
-                m_id == other.m_id && m_rows == other.m_rows);
+                m_id == other.m_id && m_rows == other.m_rows &&
+                m_num_binary_columns == other.m_num_binary_columns);
     }
 
 private:
@@ -68,6 +89,8 @@ private:
     std::string m_id;
     /// Comma-separated list of rows for copy operation (when empty: all rows)
     std::string m_rows;
+    /// Number of columns if binary COPY format is used, 0 for text format.
+    uint16_t m_num_binary_columns = 0;
 };
 
 /**
@@ -161,13 +184,16 @@ struct db_cmd_copy_t
     std::shared_ptr<db_target_descr_t> target;
     /// actual copy buffer
     std::string buffer;
+    /// Size at which the buffer is considered full
+    std::size_t max_buf_size = MAX_BUF_SIZE;
 
     db_cmd_copy_t() = default;
 
-    explicit db_cmd_copy_t(std::shared_ptr<db_target_descr_t> t)
-    : target(std::move(t))
+    explicit db_cmd_copy_t(std::shared_ptr<db_target_descr_t> t,
+                           std::size_t buf_size = MAX_BUF_SIZE)
+    : target(std::move(t)), max_buf_size(buf_size)
     {
-        buffer.reserve(MAX_BUF_SIZE);
+        buffer.reserve(max_buf_size);
     }
 
     explicit operator bool() const noexcept { return target != nullptr; }
@@ -182,7 +208,7 @@ public:
     /// Return true if the buffer is filled up.
     bool is_full() const noexcept
     {
-        return (buffer.size() > MAX_BUF_SIZE - 100) || m_deleter.is_full();
+        return (buffer.size() > max_buf_size - 100) || m_deleter.is_full();
     }
 
     bool has_deletables() const noexcept { return m_deleter.has_data(); }
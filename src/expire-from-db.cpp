@@ -0,0 +1,161 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "expire-from-db.hpp"
+
+#include "expire-tiles.hpp"
+#include "format.hpp"
+#include "logging.hpp"
+#include "pgsql.hpp"
+#include "projection.hpp"
+#include "reprojection.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <future>
+#include <vector>
+
+namespace {
+
+/// Number of ids looked up in the database in one query.
+constexpr std::size_t const ID_BATCH_SIZE = 10000;
+
+bool is_space(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * Runs in a worker thread: Get the geometries for all ids in the range
+ * [first, last) from the database and expire them.
+ */
+void expire_ids_from_db(expire_db_config_t const &db_config,
+                        idlist_t const &ids, std::size_t first,
+                        std::size_t last, expire_config_t const &expire_config,
+                        expire_tiles_t *expire)
+{
+    pg_conn_t const db_connection{db_config.connection_params, "expire"};
+
+    db_connection.prepare(
+        "get_wkb",
+        R"(SELECT ST_Transform("{}", 3857) FROM {})"
+        R"( WHERE "{}" = ANY($1::bigint[]))"
+        R"( AND "{}" IS NOT NULL)",
+        db_config.geom_column,
+        qualified_name(db_config.schema, db_config.table),
+        db_config.id_column, db_config.geom_column);
+
+    while (first < last) {
+        auto const batch_end = std::min(first + ID_BATCH_SIZE, last);
+
+        util::string_joiner_t joiner{',', '\0', '{', '}'};
+        for (auto n = first; n < batch_end; ++n) {
+            joiner.add(fmt::to_string(ids[n]));
+        }
+
+        auto const result =
+            db_connection.exec_prepared_as_binary("get_wkb", joiner());
+        expire_from_result(expire, result, expire_config);
+
+        first = batch_end;
+    }
+}
+
+} // anonymous namespace
+
+idlist_t read_ids(std::istream &input)
+{
+    idlist_t ids;
+    std::string str;
+    std::size_t line = 0;
+
+    while (std::getline(input, str)) {
+        ++line;
+
+        auto const *begin = str.data();
+        auto const *end = str.data() + str.size();
+        while (begin != end && is_space(*begin)) {
+            ++begin;
+        }
+        while (end != begin && is_space(*(end - 1))) {
+            --end;
+        }
+
+        if (begin == end) {
+            continue;
+        }
+
+        std::string const id_str{begin, end};
+        char *parse_end = nullptr;
+        errno = 0;
+        auto const id = std::strtoll(id_str.c_str(), &parse_end, 10);
+        if (errno != 0 || *parse_end != '\0') {
+            throw fmt_error("Invalid id '{}' in line {}.", id_str, line);
+        }
+
+        ids.push_back(id);
+    }
+
+    ids.sort_unique();
+
+    return ids;
+}
+
+quadkey_list_t expire_from_db(expire_db_config_t const &db_config,
+                              idlist_t const &ids,
+                              expire_config_t const &expire_config,
+                              uint32_t zoom)
+{
+    if (ids.empty()) {
+        return {};
+    }
+
+    // No need for more threads than there are batches of ids.
+    std::size_t const num_threads =
+        std::min(static_cast<std::size_t>(std::max(db_config.num_threads, 1U)),
+                 (ids.size() / ID_BATCH_SIZE) + 1);
+    std::size_t const ids_per_thread =
+        (ids.size() + num_threads - 1) / num_threads;
+
+    log_info("Reading geometries for {} ids from table {} (using {} threads)",
+             ids.size(), qualified_name(db_config.schema, db_config.table),
+             num_threads);
+
+    auto const projection =
+        reprojection_t::create_projection(PROJ_SPHERE_MERC);
+
+    std::vector<expire_tiles_t> expire_tiles;
+    expire_tiles.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        expire_tiles.emplace_back(zoom, projection);
+    }
+
+    std::vector<std::future<void>> workers;
+    workers.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        auto const first = std::min(i * ids_per_thread, ids.size());
+        auto const last = std::min(first + ids_per_thread, ids.size());
+        workers.push_back(std::async(
+            std::launch::async, expire_ids_from_db, std::cref(db_config),
+            std::cref(ids), first, last, std::cref(expire_config),
+            &expire_tiles[i]));
+    }
+
+    for (auto &worker : workers) {
+        worker.get();
+    }
+
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        expire_tiles[0].merge_and_destroy(&expire_tiles[i]);
+    }
+
+    return expire_tiles[0].get_tiles();
+}
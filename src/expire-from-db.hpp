@@ -0,0 +1,57 @@
+#ifndef OSM2PGSQL_EXPIRE_FROM_DB_HPP
+#define OSM2PGSQL_EXPIRE_FROM_DB_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "expire-config.hpp"
+#include "idlist.hpp"
+#include "pgsql-params.hpp"
+#include "tile.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+/**
+ * The database table geometries are read from by expire_from_db() and how
+ * to access it.
+ */
+struct expire_db_config_t
+{
+    connection_params_t connection_params;
+    std::string schema{"public"};
+    std::string table;
+    std::string id_column{"osm_id"};
+    std::string geom_column{"geom"};
+    uint32_t num_threads = 4;
+};
+
+/**
+ * Read ids from a stream (one per line). Whitespace around the ids and
+ * empty lines are ignored.
+ *
+ * \returns The ids sorted and without duplicates.
+ * \throws std::runtime_error if a line doesn't contain a valid id.
+ */
+idlist_t read_ids(std::istream &input);
+
+/**
+ * Get the geometries for all ids from the database table and calculate the
+ * tiles they expire. This uses several threads, each with its own database
+ * connection.
+ *
+ * \returns Sorted list of expired tiles.
+ */
+quadkey_list_t expire_from_db(expire_db_config_t const &db_config,
+                              idlist_t const &ids,
+                              expire_config_t const &expire_config,
+                              uint32_t zoom);
+
+#endif // OSM2PGSQL_EXPIRE_FROM_DB_HPP
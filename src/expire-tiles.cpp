@@ -8,11 +8,13 @@
  */
 
 #include <algorithm>
+#include <cassert>
 #include <cerrno>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 
@@ -38,11 +40,28 @@ void expire_tiles_t::expire_tile(uint32_t x, uint32_t y)
     // is different from this tile.
     tile_t const new_tile{m_maxzoom, x, y};
     if (!m_prev_tile.valid() || m_prev_tile != new_tile) {
-        m_dirty_tiles.insert(new_tile.quadkey());
+        m_dirty_tiles.push_back(new_tile.quadkey());
         m_prev_tile = new_tile;
+
+        auto const unsorted_size = m_dirty_tiles.size() - m_sorted_size;
+        if (unsorted_size >= MIN_UNSORTED_SIZE &&
+            unsorted_size >= m_sorted_size) {
+            compact();
+        }
     }
 }
 
+void expire_tiles_t::compact()
+{
+    auto const middle =
+        m_dirty_tiles.begin() + static_cast<std::ptrdiff_t>(m_sorted_size);
+    std::sort(middle, m_dirty_tiles.end());
+    std::inplace_merge(m_dirty_tiles.begin(), middle, m_dirty_tiles.end());
+    auto const last = std::unique(m_dirty_tiles.begin(), m_dirty_tiles.end());
+    m_dirty_tiles.erase(last, m_dirty_tiles.end());
+    m_sorted_size = m_dirty_tiles.size();
+}
+
 uint32_t expire_tiles_t::normalise_tile_x_coord(int x) const
 {
     x %= m_map_width;
@@ -63,9 +82,18 @@ geom::point_t expire_tiles_t::coords_to_tile(geom::point_t const &point)
 void expire_tiles_t::from_point_list(geom::point_list_t const &list,
                                      expire_config_t const &expire_config)
 {
-    for_each_segment(list, [&](geom::point_t const &a, geom::point_t const &b) {
-        from_line_segment(a, b, expire_config);
-    });
+    // Convert all points to tile coordinates in one go, so that each point
+    // is only converted once, not once for each segment it is part of.
+    m_tile_points.clear();
+    m_tile_points.reserve(list.size());
+    for (auto const &point : list) {
+        m_tile_points.push_back(coords_to_tile(point));
+    }
+
+    for_each_segment(m_tile_points,
+                     [&](geom::point_t const &a, geom::point_t const &b) {
+                         from_line_segment(a, b, expire_config);
+                     });
 }
 
 void expire_tiles_t::from_geometry(geom::point_t const &geom,
@@ -163,22 +191,24 @@ void expire_tiles_t::from_geometry_if_3857(geom::geometry_t const &geom,
 }
 
 /*
- * Expire tiles that a line crosses
+ * Expire tiles that a line crosses. The line is given in tile coordinates.
+ *
+ * This walks the tile grid row by row along the line. For each row the part
+ * of the line inside the row (extended by the buffer) is clipped out and
+ * exactly the tiles in the row covered by that part (again extended by the
+ * buffer) are expired. So every tile is visited at most once per segment.
  */
-void expire_tiles_t::from_line_segment(geom::point_t const &a,
-                                       geom::point_t const &b,
+void expire_tiles_t::from_line_segment(geom::point_t tilec_a,
+                                       geom::point_t tilec_b,
                                        expire_config_t const &expire_config)
 {
-    auto tilec_a = coords_to_tile(a);
-    auto tilec_b = coords_to_tile(b);
-
     if (tilec_a.x() > tilec_b.x()) {
         /* We always want the line to go from left to right - swap the ends if it doesn't */
         std::swap(tilec_a, tilec_b);
     }
 
-    double const x_len = tilec_b.x() - tilec_a.x();
-    if (x_len > m_map_width / 2) { // NOLINT(bugprone-integer-division)
+    if (tilec_b.x() - tilec_a.x() >
+        m_map_width / 2) { // NOLINT(bugprone-integer-division)
         /* If the line is wider than half the map, assume it
            crosses the international date line.
            These coordinates get normalised again later */
@@ -186,39 +216,40 @@ void expire_tiles_t::from_line_segment(geom::point_t const &a,
         std::swap(tilec_a, tilec_b);
     }
 
+    /* From here on the line goes from top to bottom */
+    if (tilec_a.y() > tilec_b.y()) {
+        std::swap(tilec_a, tilec_b);
+    }
+
+    double const buffer = expire_config.buffer;
+    double const x_len = tilec_b.x() - tilec_a.x();
     double const y_len = tilec_b.y() - tilec_a.y();
-    double const hyp_len =
-        std::sqrt(x_len * x_len + y_len * y_len); /* Pythagoras */
-    double const x_step = x_len / hyp_len;
-    double const y_step = y_len / hyp_len;
-
-    for (int i = 0; i <= hyp_len / 0.4; ++i) {
-        double const step = i * 0.4;
-        double const next_step = std::min(hyp_len, (i + 1) * 0.4);
-
-        double const x1 = tilec_a.x() + (step * x_step);
-        double y1 = tilec_a.y() + (step * y_step);
-        double const x2 = tilec_a.x() + (next_step * x_step);
-        double y2 = tilec_a.y() + (next_step * y_step);
-
-        /* The line (x1,y1),(x2,y2) is up to 1 tile width long
-           x1 will always be <= x2
-           We could be smart and figure out the exact tiles intersected,
-           but for simplicity, treat the coordinates as a bounding box
-           and expire everything within that box. */
+
+    int const min_y = std::max(0, static_cast<int>(tilec_a.y() - buffer));
+    int const max_y =
+        std::min(m_map_width - 1, static_cast<int>(tilec_b.y() + buffer));
+
+    for (int y = min_y; y <= max_y; ++y) {
+        double const y1 = std::max(tilec_a.y(), y - buffer);
+        double const y2 = std::min(tilec_b.y(), y + 1 + buffer);
         if (y1 > y2) {
-            std::swap(y1, y2);
+            continue;
         }
-        for (int x = static_cast<int>(x1 - expire_config.buffer);
-             x <= static_cast<int>(x2 + expire_config.buffer); ++x) {
-            uint32_t const norm_x = normalise_tile_x_coord(x);
-            for (int y = static_cast<int>(y1 - expire_config.buffer);
-                 y <= static_cast<int>(y2 + expire_config.buffer); ++y) {
-                if (y >= 0) {
-                    expire_tile(norm_x, static_cast<uint32_t>(y));
-                }
+
+        double x1 = tilec_a.x();
+        double x2 = tilec_b.x();
+        if (y_len > 0) {
+            x1 = tilec_a.x() + ((y1 - tilec_a.y()) / y_len) * x_len;
+            x2 = tilec_a.x() + ((y2 - tilec_a.y()) / y_len) * x_len;
+            if (x1 > x2) {
+                std::swap(x1, x2);
             }
         }
+
+        for (int x = static_cast<int>(x1 - buffer);
+             x <= static_cast<int>(x2 + buffer); ++x) {
+            expire_tile(normalise_tile_x_coord(x), static_cast<uint32_t>(y));
+        }
     }
 }
 
@@ -273,14 +304,38 @@ int expire_tiles_t::from_bbox(geom::box_t const &box,
 
 quadkey_list_t expire_tiles_t::get_tiles()
 {
+    compact();
+
     quadkey_list_t tiles;
-    tiles.reserve(m_dirty_tiles.size());
-    tiles.assign(m_dirty_tiles.cbegin(), m_dirty_tiles.cend());
-    std::sort(tiles.begin(), tiles.end());
-    m_dirty_tiles.clear();
+    using std::swap;
+    swap(tiles, m_dirty_tiles);
+    m_sorted_size = 0;
+    m_prev_tile = tile_t{};
+
     return tiles;
 }
 
+void expire_tiles_t::append_and_clear(expire_tiles_t *other)
+{
+    assert(m_map_width == other->m_map_width);
+
+    m_dirty_tiles.insert(m_dirty_tiles.end(), other->m_dirty_tiles.cbegin(),
+                         other->m_dirty_tiles.cend());
+    other->clear();
+
+    auto const unsorted_size = m_dirty_tiles.size() - m_sorted_size;
+    if (unsorted_size >= MIN_UNSORTED_SIZE && unsorted_size >= m_sorted_size) {
+        compact();
+    }
+}
+
+void expire_tiles_t::clear() noexcept
+{
+    m_dirty_tiles.clear();
+    m_sorted_size = 0;
+    m_prev_tile = tile_t{};
+}
+
 void expire_tiles_t::merge_and_destroy(expire_tiles_t *other)
 {
     if (m_map_width != other->m_map_width) {
@@ -289,14 +344,30 @@ void expire_tiles_t::merge_and_destroy(expire_tiles_t *other)
                         m_map_width, other->m_map_width);
     }
 
+    other->compact();
+
     if (m_dirty_tiles.empty()) {
         using std::swap;
         swap(m_dirty_tiles, other->m_dirty_tiles);
+        m_sorted_size = m_dirty_tiles.size();
     } else {
-        m_dirty_tiles.insert(other->m_dirty_tiles.cbegin(),
-                             other->m_dirty_tiles.cend());
-        other->m_dirty_tiles.clear();
+        compact();
+
+        quadkey_list_t new_list;
+        new_list.reserve(m_dirty_tiles.size() + other->m_dirty_tiles.size());
+        std::set_union(m_dirty_tiles.cbegin(), m_dirty_tiles.cend(),
+                       other->m_dirty_tiles.cbegin(),
+                       other->m_dirty_tiles.cend(),
+                       std::back_inserter(new_list));
+
+        using std::swap;
+        swap(new_list, m_dirty_tiles);
+        m_sorted_size = m_dirty_tiles.size();
     }
+
+    other->m_dirty_tiles = quadkey_list_t{};
+    other->m_sorted_size = 0;
+    other->m_prev_tile = tile_t{};
 }
 
 int expire_from_result(expire_tiles_t *expire, pg_result_t const &result,
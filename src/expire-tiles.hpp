@@ -13,7 +13,6 @@
 #include <cstdint>
 #include <memory>
 #include <string_view>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -77,17 +76,30 @@ public:
     int from_bbox(geom::box_t const &box, expire_config_t const &expire_config);
 
     /**
-     * Get tiles as a vector of quadkeys and remove them from the expire_tiles_t
-     * object.
+     * Get tiles as a sorted vector of quadkeys and remove them from the
+     * expire_tiles_t object.
      */
     quadkey_list_t get_tiles();
 
     /**
      * Merge the list of expired tiles in the other object into this
-     * object, destroying the list in the other object.
+     * object, destroying the list in the other object. Both lists are
+     * sorted, so this is a linear merge.
+     *
+     * Merging into different objects from different threads is safe.
      */
     void merge_and_destroy(expire_tiles_t *other);
 
+    /**
+     * Move the list of expired tiles in the other object into this object.
+     * The tiles are only appended to the unsorted part of the list, so
+     * unlike merge_and_destroy() this is cheap for small lists.
+     */
+    void append_and_clear(expire_tiles_t *other);
+
+    /// Forget all expired tiles.
+    void clear() noexcept;
+
 private:
     /**
      * Converts from target coordinates to tile coordinates.
@@ -104,18 +116,41 @@ private:
 
     uint32_t normalise_tile_x_coord(int x) const;
 
-    void from_line_segment(geom::point_t const &a, geom::point_t const &b,
+    /// Expire tiles along a line segment given in tile coordinates.
+    void from_line_segment(geom::point_t tilec_a, geom::point_t tilec_b,
                            expire_config_t const &expire_config);
 
     void from_point_list(geom::point_list_t const &list,
                          expire_config_t const &expire_config);
 
-    /// This is where we collect all the expired tiles.
-    std::unordered_set<quadkey_t> m_dirty_tiles;
+    /**
+     * Sort the unsorted tail of m_dirty_tiles, merge it into the sorted
+     * part and remove duplicates.
+     */
+    void compact();
 
-    /// The tile which has been added last to the unordered set.
+    /**
+     * Compact the tile list when the unsorted tail has at least this many
+     * entries and is at least as large as the sorted part.
+     */
+    static constexpr std::size_t MIN_UNSORTED_SIZE = 1024;
+
+    /**
+     * This is where we collect all the expired tiles. The first
+     * m_sorted_size entries are sorted and unique, the rest are appended
+     * unsorted and possibly with duplicates until the next compact().
+     */
+    quadkey_list_t m_dirty_tiles;
+
+    /// Number of entries at the start of m_dirty_tiles that are sorted.
+    std::size_t m_sorted_size = 0;
+
+    /// The tile which has been added last to the list.
     tile_t m_prev_tile;
 
+    /// Buffer for points converted to tile coordinates (reused).
+    geom::point_list_t m_tile_points;
+
     std::shared_ptr<reprojection_t> m_projection;
 
     uint32_t m_maxzoom;
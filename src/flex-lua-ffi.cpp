@@ -0,0 +1,71 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "flex-lua-ffi.hpp"
+
+#include <osmium/osm/object.hpp>
+
+#include <lua.hpp>
+
+// The Lua wrappers in init.lua raise an error if the object pointer is nil,
+// the checks for null pointers here are only a safety net.
+extern "C" {
+
+char const *osm2pgsql_ffi_get_tag(void const *object, char const *key)
+{
+    if (!object || !key) {
+        return nullptr;
+    }
+
+    return static_cast<osmium::OSMObject const *>(object)->tags()[key];
+}
+
+int osm2pgsql_ffi_get_tags(void const *object, osm2pgsql_tag_t *tags,
+                           int size)
+{
+    if (!object || !tags) {
+        return 0;
+    }
+
+    int count = 0;
+    for (auto const &tag :
+         static_cast<osmium::OSMObject const *>(object)->tags()) {
+        if (count == size) {
+            break;
+        }
+        tags[count].key = tag.key();
+        tags[count].value = tag.value();
+        ++count;
+    }
+
+    return count;
+}
+
+} // extern "C"
+
+namespace {
+
+template <typename FUNC>
+void add_function_pointer(lua_State *lua_state, char const *name, FUNC *func)
+{
+    lua_pushstring(lua_state, name);
+    lua_pushlightuserdata(lua_state, reinterpret_cast<void *>(func));
+    lua_rawset(lua_state, -3);
+}
+
+} // anonymous namespace
+
+void add_ffi_functions(lua_State *lua_state)
+{
+    lua_pushliteral(lua_state, "_ffi_functions");
+    lua_createtable(lua_state, 0, 2);
+    add_function_pointer(lua_state, "get_tag", osm2pgsql_ffi_get_tag);
+    add_function_pointer(lua_state, "get_tags", osm2pgsql_ffi_get_tags);
+    lua_rawset(lua_state, -3);
+}
@@ -0,0 +1,58 @@
+#ifndef OSM2PGSQL_FLEX_LUA_FFI_HPP
+#define OSM2PGSQL_FLEX_LUA_FFI_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+/**
+ * \file
+ *
+ * Functions for accessing OSM objects from Lua through the LuaJIT FFI.
+ * Calls through the FFI can be compiled by the JIT compiler, calls to
+ * functions using the normal Lua C API can not. This is only available
+ * when osm2pgsql is built with LuaJIT.
+ */
+
+struct lua_State;
+
+// The functions in here are called from Lua code through the FFI, so they
+// must have C linkage and only use C types. The declarations must match
+// the ones in the ffi.cdef in init.lua. The object pointer is the light
+// userdata in the "_ffi" field of the Lua object.
+extern "C" {
+
+struct osm2pgsql_tag_t
+{
+    char const *key;
+    char const *value;
+};
+
+/**
+ * Return the value of the tag with the specified key of the OSM object or
+ * a null pointer if there is no such tag or the object pointer is null.
+ */
+char const *osm2pgsql_ffi_get_tag(void const *object, char const *key);
+
+/**
+ * Fill the array 'tags' with at most 'size' tags of the OSM object and
+ * return the number of tags written.
+ */
+int osm2pgsql_ffi_get_tags(void const *object, osm2pgsql_tag_t *tags,
+                           int size);
+
+} // extern "C"
+
+/**
+ * Add the "_ffi_functions" field with pointers to the FFI functions to the
+ * table on top of the Lua stack. The Lua side of the interface in init.lua
+ * uses them to create the "osm2pgsql.ffi" table.
+ */
+void add_ffi_functions(lua_State *lua_state);
+
+#endif // OSM2PGSQL_FLEX_LUA_FFI_HPP
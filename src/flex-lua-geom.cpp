@@ -16,7 +16,7 @@
 
 #include <lua.hpp>
 
-static char const *const OSM2PGSQL_GEOMETRY_CLASS = "osm2pgsql.Geometry";
+char const *const OSM2PGSQL_GEOMETRY_CLASS = "osm2pgsql.Geometry";
 
 geom::geometry_t *create_lua_geometry_object(lua_State *lua_state)
 {
@@ -20,6 +20,9 @@
 
 struct lua_State;
 
+/// Name of the metatable of the osm2pgsql.Geometry class.
+extern char const *const OSM2PGSQL_GEOMETRY_CLASS;
+
 /**
  * Create a null geometry object on the Lua stack and return a pointer to it.
  */
@@ -0,0 +1,220 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "flex-lua-profile.hpp"
+
+#include "format.hpp"
+#include "logging.hpp"
+
+#include <lua.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+char const *const OSM2PGSQL_PROFILE = "osm2pgsql.profile";
+
+using profile_clock = std::chrono::steady_clock;
+
+/**
+ * CPU time used by the current thread. Returns 0 on systems where this
+ * is not available.
+ */
+std::chrono::nanoseconds thread_cpu_time() noexcept
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return std::chrono::seconds{ts.tv_sec} +
+               std::chrono::nanoseconds{ts.tv_nsec};
+    }
+#endif
+    return std::chrono::nanoseconds{};
+}
+
+double to_seconds(std::chrono::nanoseconds duration) noexcept
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+/**
+ * This is used instead of the original C function in a Lua metatable. The
+ * original function is in the first upvalue, the profile entry in the
+ * second.
+ */
+int profiled_function(lua_State *lua_state)
+{
+    auto *const entry = static_cast<flex_lua_profile_t::entry_t *>(
+        lua_touserdata(lua_state, lua_upvalueindex(2)));
+    auto const func = lua_tocfunction(lua_state, lua_upvalueindex(1));
+    assert(entry && func);
+
+    flex_lua_profile_t::scope_t const scope{entry};
+    return func(lua_state);
+}
+
+void log_entries(
+    char const *title,
+    std::map<std::string, flex_lua_profile_t::entry_t, std::less<>> const
+        &entries)
+{
+    if (entries.empty()) {
+        return;
+    }
+
+    log_info("  {:<40} {:>12} {:>10} {:>10}", title, "calls", "wall (s)",
+             "cpu (s)");
+    for (auto const &[name, entry] : entries) {
+        log_info("  {:<40} {:>12} {:>10.3f} {:>10.3f}", name, entry.calls,
+                 to_seconds(entry.wall), to_seconds(entry.cpu));
+    }
+}
+
+} // anonymous namespace
+
+flex_lua_profile_t::scope_t::scope_t(flex_lua_profile_t *profile,
+                                     category cat, std::string_view name)
+{
+    if (!profile) {
+        return;
+    }
+
+    m_entry = &profile->entry(cat, name);
+    m_wall_start = profile_clock::now();
+    m_cpu_start = thread_cpu_time();
+
+    if (cat == category::callback) {
+        profile->m_last_sample = m_wall_start;
+    }
+}
+
+flex_lua_profile_t::scope_t::scope_t(entry_t *entry) noexcept
+: m_entry(entry), m_wall_start(profile_clock::now()),
+  m_cpu_start(thread_cpu_time())
+{}
+
+flex_lua_profile_t::scope_t::~scope_t() noexcept
+{
+    if (!m_entry) {
+        return;
+    }
+
+    ++m_entry->calls;
+    m_entry->wall += profile_clock::now() - m_wall_start;
+    m_entry->cpu += thread_cpu_time() - m_cpu_start;
+}
+
+flex_lua_profile_t::entry_t &flex_lua_profile_t::entry(category cat,
+                                                       std::string_view name)
+{
+    auto &entries = m_entries.at(static_cast<std::size_t>(cat));
+    auto const it = entries.find(name);
+    if (it != entries.end()) {
+        return it->second;
+    }
+    return entries.emplace(std::string{name}, entry_t{}).first->second;
+}
+
+void flex_lua_profile_t::wrap_functions(lua_State *lua_state,
+                                        char const *luaclass,
+                                        char const *prefix)
+{
+    luaL_getmetatable(lua_state, luaclass);
+    assert(lua_istable(lua_state, -1));
+
+    // Collect names first, the table can't be changed while iterating.
+    std::vector<std::string> names;
+    lua_pushnil(lua_state);
+    while (lua_next(lua_state, -2) != 0) {
+        if (lua_type(lua_state, -2) == LUA_TSTRING &&
+            lua_iscfunction(lua_state, -1)) {
+            std::string name{lua_tostring(lua_state, -2)};
+            if (name.rfind("__", 0) != 0) {
+                names.push_back(std::move(name));
+            }
+        }
+        lua_pop(lua_state, 1); // value
+    }
+
+    for (auto const &name : names) {
+        lua_getfield(lua_state, -1, name.c_str());
+        lua_pushlightuserdata(
+            lua_state,
+            &entry(category::function, fmt::format("{}.{}", prefix, name)));
+        lua_pushcclosure(lua_state, profiled_function, 2);
+        lua_setfield(lua_state, -2, name.c_str());
+    }
+
+    lua_pop(lua_state, 1); // metatable
+}
+
+void flex_lua_profile_t::enable_line_sampling(lua_State *lua_state)
+{
+    lua_pushlightuserdata(lua_state, this);
+    lua_setfield(lua_state, LUA_REGISTRYINDEX, OSM2PGSQL_PROFILE);
+    lua_sethook(lua_state, line_hook, LUA_MASKCOUNT, SAMPLE_INSTRUCTIONS);
+}
+
+void flex_lua_profile_t::line_hook(lua_State *lua_state, lua_Debug *debug)
+{
+    lua_getfield(lua_state, LUA_REGISTRYINDEX, OSM2PGSQL_PROFILE);
+    auto *const profile =
+        static_cast<flex_lua_profile_t *>(lua_touserdata(lua_state, -1));
+    lua_pop(lua_state, 1);
+
+    if (!profile || !lua_getinfo(lua_state, "Sl", debug)) {
+        return;
+    }
+
+    auto const now = profile_clock::now();
+    auto &entry = profile->entry(
+        category::line,
+        fmt::format("{}:{}", debug->short_src, debug->currentline));
+    ++entry.calls;
+    if (profile->m_last_sample != profile_clock::time_point{}) {
+        entry.wall += now - profile->m_last_sample;
+    }
+    profile->m_last_sample = now;
+}
+
+void flex_lua_profile_t::log_summary() const
+{
+    log_info("Lua profile (times include nested calls):");
+    log_entries("Callback",
+                m_entries[static_cast<std::size_t>(category::callback)]);
+    log_entries("Insert into table",
+                m_entries[static_cast<std::size_t>(category::insert)]);
+    log_entries("Function",
+                m_entries[static_cast<std::size_t>(category::function)]);
+
+    auto const &lines = m_entries[static_cast<std::size_t>(category::line)];
+    if (lines.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<std::string_view, entry_t>> sorted{lines.cbegin(),
+                                                             lines.cend()};
+    std::sort(sorted.begin(), sorted.end(), [](auto const &a, auto const &b) {
+        return a.second.wall > b.second.wall;
+    });
+    if (sorted.size() > MAX_LINES_IN_SUMMARY) {
+        sorted.resize(MAX_LINES_IN_SUMMARY);
+    }
+
+    log_info("  {:<40} {:>12} {:>10}", "Lua source line", "samples",
+             "wall (s)");
+    for (auto const &[name, entry] : sorted) {
+        log_info("  {:<40} {:>12} {:>10.3f}", name, entry.calls,
+                 to_seconds(entry.wall));
+    }
+}
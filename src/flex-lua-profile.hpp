@@ -0,0 +1,118 @@
+#ifndef OSM2PGSQL_FLEX_LUA_PROFILE_HPP
+#define OSM2PGSQL_FLEX_LUA_PROFILE_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+struct lua_State;
+struct lua_Debug;
+
+/**
+ * Collects timing information about the Lua code run by the flex output:
+ * How much time is spent in the Lua callbacks, in the insert() calls for
+ * each table, and in the functions on OSM objects and geometries called
+ * from Lua. Optionally a Lua hook samples which line of the Lua code is
+ * running to find out where the time inside the callbacks goes.
+ *
+ * All times include the time spent in nested calls, so the time for a
+ * callback includes the time for all insert() calls from that callback.
+ *
+ * This class is not thread-safe. It must only be used while holding the
+ * Lua mutex.
+ */
+class flex_lua_profile_t
+{
+public:
+    /// Run the line sampling hook every this many Lua VM instructions.
+    static constexpr int SAMPLE_INSTRUCTIONS = 1000;
+
+    /// The number of lines shown in the summary.
+    static constexpr std::size_t MAX_LINES_IN_SUMMARY = 20;
+
+    enum class category : std::uint8_t
+    {
+        callback = 0, ///< Lua callbacks like process_node()
+        insert = 1,   ///< insert() calls, per table
+        function = 2, ///< Functions on OSM objects and geometries
+        line = 3      ///< Samples per Lua source line
+    };
+
+    struct entry_t
+    {
+        std::size_t calls = 0;
+        std::chrono::nanoseconds wall{};
+        std::chrono::nanoseconds cpu{};
+    };
+
+    /**
+     * Measures wall clock and CPU time from construction to destruction
+     * and adds it to an entry. Does nothing if the profile is nullptr, so
+     * this can be used unconditionally.
+     */
+    class scope_t
+    {
+    public:
+        scope_t(flex_lua_profile_t *profile, category cat,
+                std::string_view name);
+
+        explicit scope_t(entry_t *entry) noexcept;
+
+        scope_t(scope_t const &) = delete;
+        scope_t &operator=(scope_t const &) = delete;
+
+        scope_t(scope_t &&) = delete;
+        scope_t &operator=(scope_t &&) = delete;
+
+        ~scope_t() noexcept;
+
+    private:
+        entry_t *m_entry = nullptr;
+        std::chrono::steady_clock::time_point m_wall_start;
+        std::chrono::nanoseconds m_cpu_start{};
+    }; // class scope_t
+
+    entry_t &entry(category cat, std::string_view name);
+
+    /**
+     * Replace all functions in the metatable of the specified Lua class
+     * (except the special "__" functions) by wrappers which record how
+     * long they take under the name "prefix.function".
+     */
+    void wrap_functions(lua_State *lua_state, char const *luaclass,
+                        char const *prefix);
+
+    /// Install the Lua hook sampling the current source line.
+    void enable_line_sampling(lua_State *lua_state);
+
+    /// Write summary of all collected timings to the log.
+    void log_summary() const;
+
+private:
+    static void line_hook(lua_State *lua_state, lua_Debug *debug);
+
+    std::array<std::map<std::string, entry_t, std::less<>>, 4> m_entries;
+
+    /**
+     * Time of the last line sample. Time before this (when no Lua code was
+     * running) is not attributed to any line.
+     */
+    std::chrono::steady_clock::time_point m_last_sample;
+
+}; // class flex_lua_profile_t
+
+#endif // OSM2PGSQL_FLEX_LUA_PROFILE_HPP
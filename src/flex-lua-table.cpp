@@ -69,9 +69,12 @@ flex_table_t &create_flex_table(lua_State *lua_state,
             new_table.set_cluster_by_geom(true);
         } else if (cluster == "no") {
             new_table.set_cluster_by_geom(false);
+        } else if (cluster == "sort") {
+            new_table.set_cluster_by_geom(false);
+            new_table.set_sort_by_geom(true);
         } else {
             throw fmt_error("Unknown value '{}' for 'cluster' table option"
-                            " (use 'auto' or 'no').",
+                            " (use 'auto', 'sort', or 'no').",
                             cluster);
         }
     } else if (cluster_type == LUA_TNIL) {
@@ -82,6 +85,44 @@ flex_table_t &create_flex_table(lua_State *lua_state,
     }
     lua_pop(lua_state, 1);
 
+    // optional "copy_format" field
+    lua_getfield(lua_state, -1, "copy_format");
+    int const copy_format_type = lua_type(lua_state, -1);
+    if (copy_format_type == LUA_TSTRING) {
+        std::string const copy_format = lua_tostring(lua_state, -1);
+        if (copy_format == "text") {
+            new_table.set_binary_copy(false);
+        } else if (copy_format == "binary") {
+            new_table.set_binary_copy(true);
+        } else {
+            throw fmt_error("Unknown value '{}' for 'copy_format' table option"
+                            " (use 'text' or 'binary').",
+                            copy_format);
+        }
+    } else if (copy_format_type != LUA_TNIL) {
+        throw std::runtime_error{
+            "Unknown value for 'copy_format' table option: Must be string."};
+    }
+    lua_pop(lua_state, 1);
+
+    // optional "partition_zoom" field
+    new_table.set_partition_zoom(luaX_get_table_optional_uint32(
+        lua_state, "partition_zoom", -1,
+        "The 'partition_zoom' table option", 1,
+        flex_table_t::MAX_PARTITION_ZOOM, "1 and 4"));
+    lua_pop(lua_state, 1); // "partition_zoom"
+
+    // optional "detect_changes" field
+    new_table.set_detect_changes(
+        luaX_get_table_bool(lua_state, "detect_changes", -1,
+                            "The 'detect_changes' table option", false));
+    lua_pop(lua_state, 1); // "detect_changes"
+
+    // optional "ephemeral" field
+    new_table.set_ephemeral(luaX_get_table_bool(
+        lua_state, "ephemeral", -1, "The 'ephemeral' table option", false));
+    lua_pop(lua_state, 1); // "ephemeral"
+
     // optional "data_tablespace" field
     lua_getfield(lua_state, -1, "data_tablespace");
     if (lua_isstring(lua_state, -1)) {
@@ -166,8 +207,8 @@ void setup_flex_table_id_columns(lua_State *lua_state, flex_table_t *table)
     } else if (type == "tile") {
         table->set_id_type(flex_table_index_type::tile);
         parse_create_index(lua_state, table);
-        table->add_column("x", "int", "int").set_not_null();
-        table->add_column("y", "int", "int").set_not_null();
+        table->add_column("x", "int", "").set_not_null();
+        table->add_column("y", "int", "").set_not_null();
         lua_pop(lua_state, 1); // "ids"
         return;
     } else {
@@ -306,6 +347,63 @@ void parse_and_set_expire_options(lua_State *lua_state,
     });
 }
 
+/**
+ * Set up a column derived from a geometry column defined earlier. The
+ * "derive" field is on top of the Lua stack, the column definition below.
+ */
+void setup_flex_table_derived_column(lua_State *lua_state,
+                                     flex_table_t const &table,
+                                     flex_table_column_t *column)
+{
+    if (lua_type(lua_state, -1) != LUA_TSTRING) {
+        throw fmt_error("The 'derive' field of column '{}' must be a string.",
+                        column->name());
+    }
+    std::string const func = lua_tostring(lua_state, -1);
+
+    if (column->create_only()) {
+        throw fmt_error("Derived column '{}' can not be create_only.",
+                        column->name());
+    }
+
+    std::string const from = luaX_get_table_string(
+        lua_state, "from", -2, "Derived column entry");
+    lua_pop(lua_state, 1); // "from"
+
+    // The column itself is the last one in the table, the source column
+    // must be one of the columns defined before it.
+    auto const &columns = table.columns();
+    std::size_t source = 0;
+    while (source < columns.size() - 1 && columns[source].name() != from) {
+        ++source;
+    }
+    if (source == columns.size() - 1) {
+        throw fmt_error("Source column '{}' of derived column '{}' must be"
+                        " defined before it.",
+                        from, column->name());
+    }
+    if (!columns[source].is_geometry_column() ||
+        columns[source].is_derived() || columns[source].create_only()) {
+        throw fmt_error("Source column '{}' of derived column '{}' must be"
+                        " a geometry column filled from Lua.",
+                        from, column->name());
+    }
+
+    double tolerance = 0.0;
+    lua_getfield(lua_state, -2, "tolerance");
+    int const ltype = lua_type(lua_state, -1);
+    if (ltype == LUA_TNUMBER) {
+        tolerance = lua_tonumber(lua_state, -1);
+    } else if (ltype != LUA_TNIL) {
+        throw fmt_error("The 'tolerance' field of column '{}' must be a"
+                        " number.",
+                        column->name());
+    }
+    lua_pop(lua_state, 1); // "tolerance"
+
+    column->set_derived(func, source, tolerance);
+}
+
 void setup_flex_table_columns(lua_State *lua_state, flex_table_t *table,
                               std::vector<expire_output_t> *expire_outputs,
                               bool append_mode)
@@ -340,6 +438,12 @@ void setup_flex_table_columns(lua_State *lua_state, flex_table_t *table,
         auto &column = table->add_column(name, type, sql_type);
         lua_pop(lua_state, 3); // "type", "column", "sql_type"
 
+        if (column.type() == table_column_type::row_hash) {
+            throw fmt_error("Column type '{}' of column '{}' is reserved for"
+                            " the row hash in tables with change detection.",
+                            column.type_name(), column.name());
+        }
+
         column.set_not_null(luaX_get_table_bool(lua_state, "not_null", -1,
                                                 "Entry 'not_null'", false));
         lua_pop(lua_state, 1); // "not_null"
@@ -359,6 +463,12 @@ void setup_flex_table_columns(lua_State *lua_state, flex_table_t *table,
         }
         lua_pop(lua_state, 1); // "projection"
 
+        lua_getfield(lua_state, -1, "derive");
+        if (!lua_isnil(lua_state, -1)) {
+            setup_flex_table_derived_column(lua_state, *table, &column);
+        }
+        lua_pop(lua_state, 1); // "derive"
+
         lua_getfield(lua_state, -1, "expire");
         parse_and_set_expire_options(lua_state, &column, expire_outputs->size(),
                                      append_mode);
@@ -418,6 +528,126 @@ void setup_flex_table_indexes(lua_State *lua_state, flex_table_t *table,
     lua_pop(lua_state, 1); // "indexes"
 }
 
+/**
+ * Partitioned tables get an additional column with the partition number
+ * which is calculated from the geometry.
+ */
+void setup_flex_table_partition_column(flex_table_t *table)
+{
+    if (!table->has_geom_column()) {
+        throw fmt_error("Partitioned table '{}' must have a geometry column.",
+                        table->name());
+    }
+
+    for (auto const &column : table->columns()) {
+        if (column.name() == flex_table_t::PARTITION_COLUMN) {
+            throw fmt_error("Column name '{}' is reserved for the partition"
+                            " number in partitioned table '{}'.",
+                            column.name(), table->name());
+        }
+    }
+
+    auto &column = table->add_column(flex_table_t::PARTITION_COLUMN,
+                                     "partition", "");
+    column.set_not_null();
+}
+
+/**
+ * Tables with change detection get an additional column with a hash of the
+ * row contents. This must be the last column, because the hash is
+ * calculated from all other columns.
+ */
+void setup_flex_table_hash_column(flex_table_t *table)
+{
+    if (!table->has_id_column()) {
+        throw fmt_error("Table '{}' needs an id column for change detection.",
+                        table->name());
+    }
+
+    for (auto &column : table->columns()) {
+        if (column.name() == flex_table_t::HASH_COLUMN) {
+            throw fmt_error("Column name '{}' is reserved for the row hash"
+                            " in table '{}' with change detection.",
+                            column.name(), table->name());
+        }
+        if (column.type() == table_column_type::hstore) {
+            column.set_sort_keys();
+        }
+    }
+
+    auto &column =
+        table->add_column(flex_table_t::HASH_COLUMN, "row_hash", "");
+    column.set_not_null();
+}
+
+/**
+ * Ephemeral tables don't exist in the database, so all options concerning
+ * the database table can't be used with them.
+ */
+void check_ephemeral_table(lua_State *lua_state, flex_table_t *table)
+{
+    if (table->partitioned()) {
+        throw fmt_error("Can not use 'partition_zoom' on ephemeral"
+                        " table '{}'.",
+                        table->name());
+    }
+
+    if (table->detect_changes()) {
+        throw fmt_error("Can not use 'detect_changes' on ephemeral"
+                        " table '{}'.",
+                        table->name());
+    }
+
+    lua_getfield(lua_state, -1, "indexes");
+    if (!lua_isnil(lua_state, -1)) {
+        throw fmt_error("Can not define indexes on ephemeral table '{}'.",
+                        table->name());
+    }
+    lua_pop(lua_state, 1); // "indexes"
+
+    for (auto const &column : table->columns()) {
+        if (column.is_derived()) {
+            throw fmt_error("Can not use derived column '{}' in ephemeral"
+                            " table '{}'.",
+                            column.name(), table->name());
+        }
+    }
+
+    table->set_cluster_by_geom(false);
+    table->set_sort_by_geom(false);
+}
+
+/**
+ * Index names must be unique in a schema, so they can't be used on the
+ * partitions which each get their own indexes.
+ */
+void check_partitioned_table_indexes(flex_table_t const &table)
+{
+    for (auto const &index : table.indexes()) {
+        if (!index.name().empty()) {
+            throw fmt_error("Can not set index name '{}' on partitioned"
+                            " table '{}'.",
+                            index.name(), table.name());
+        }
+    }
+}
+
+/**
+ * The binary COPY format needs to know the exact database type of each
+ * column, which osm2pgsql can't know for columns with a user-defined SQL
+ * type.
+ */
+void check_binary_copy_columns(flex_table_t const &table)
+{
+    for (auto const &column : table.columns()) {
+        if (!column.create_only() && column.has_sql_type()) {
+            throw fmt_error("Can not use binary COPY format for table '{}',"
+                            " because column '{}' has a 'sql_type' set.",
+                            table.name(), column.name());
+        }
+    }
+}
+
 TRAMPOLINE_WRAPPED_OBJECT(table, tostring)
 TRAMPOLINE_WRAPPED_OBJECT(table, cluster)
 TRAMPOLINE_WRAPPED_OBJECT(table, columns)
@@ -440,7 +670,23 @@ int setup_flex_table(lua_State *lua_state, std::vector<flex_table_t> *tables,
     setup_flex_table_id_columns(lua_state, &new_table);
     setup_flex_table_columns(lua_state, &new_table, expire_outputs,
                              append_mode);
-    setup_flex_table_indexes(lua_state, &new_table, updatable);
+    if (new_table.partitioned()) {
+        setup_flex_table_partition_column(&new_table);
+    }
+    if (new_table.detect_changes()) {
+        setup_flex_table_hash_column(&new_table);
+    }
+    if (new_table.binary_copy()) {
+        check_binary_copy_columns(new_table);
+    }
+    if (new_table.ephemeral()) {
+        check_ephemeral_table(lua_state, &new_table);
+    } else {
+        setup_flex_table_indexes(lua_state, &new_table, updatable);
+    }
+    if (new_table.partitioned()) {
+        check_partitioned_table_indexes(new_table);
+    }
 
     void *ptr = lua_newuserdata(lua_state, sizeof(std::size_t));
     auto *num = new (ptr) std::size_t{};
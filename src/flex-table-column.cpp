@@ -56,7 +56,9 @@ std::vector<column_type_lookup> const COLUMN_TYPES = {
      {"multipolygon", table_column_type::multipolygon},
      {"geometrycollection", table_column_type::geometrycollection},
      {"id_type", table_column_type::id_type},
-     {"id_num", table_column_type::id_num}}};
+     {"id_num", table_column_type::id_num},
+     {"partition", table_column_type::partition},
+     {"row_hash", table_column_type::row_hash}}};
 
 table_column_type get_column_type_from_string(std::string const &type)
 {
@@ -123,6 +125,46 @@ void flex_table_column_t::set_projection(char const *projection)
     }
 }
 
+void flex_table_column_t::set_derived(std::string const &func,
+                                      std::size_t source, double tolerance)
+{
+    if (func == "centroid") {
+        if (m_type != table_column_type::point &&
+            m_type != table_column_type::geometry) {
+            throw fmt_error("Derived column '{}' using 'centroid' must be of"
+                            " type 'point' or 'geometry'.",
+                            m_name);
+        }
+        m_derived_func = derived_column_func::centroid;
+    } else if (func == "simplify") {
+        if (!is_geometry_column()) {
+            throw fmt_error("Derived column '{}' using 'simplify' must be a"
+                            " geometry column.",
+                            m_name);
+        }
+        if (tolerance <= 0.0) {
+            throw fmt_error("Derived column '{}' using 'simplify' needs a"
+                            " positive 'tolerance'.",
+                            m_name);
+        }
+        m_derived_func = derived_column_func::simplify;
+        m_tolerance = tolerance;
+    } else if (func == "area" || func == "length") {
+        if (m_type != table_column_type::real) {
+            throw fmt_error("Derived column '{}' using '{}' must be of type"
+                            " 'real'.",
+                            m_name, func);
+        }
+        m_derived_func = func == "area" ? derived_column_func::area
+                                        : derived_column_func::length;
+    } else {
+        throw fmt_error("Unknown function '{}' for derived column '{}'.", func,
+                        m_name);
+    }
+
+    m_derived_from = source;
+}
+
 std::string flex_table_column_t::sql_type_name() const
 {
     if (!m_sql_type.empty()) {
@@ -170,6 +212,10 @@ std::string flex_table_column_t::sql_type_name() const
         return "char(1)";
     case table_column_type::id_num:
         return "int8";
+    case table_column_type::partition:
+        return "int2";
+    case table_column_type::row_hash:
+        return "int8";
     }
     throw std::runtime_error{"Unknown column type."};
 }
@@ -16,6 +16,7 @@
 #include "projection.hpp"
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -48,7 +49,23 @@ enum class table_column_type : uint8_t
     geometrycollection,
 
     id_type,
-    id_num
+    id_num,
+
+    partition,
+    row_hash
+};
+
+/**
+ * Function used to calculate the contents of a derived column from the
+ * geometry in its source column.
+ */
+enum class derived_column_func : uint8_t
+{
+    none,
+    centroid,
+    simplify,
+    area,
+    length
 };
 
 /**
@@ -90,10 +107,10 @@ public:
     }
 
     /**
-     * Do we need an ST_IsValid() check in the database for this geometry
-     * column? If the SRID is 4326 the geometry validity is already assured
-     * by libosmium, so we don't need it. And Point geometries are always
-     * valid.
+     * Do we need a validity check for this geometry column? The check is
+     * done before the geometry is written to the database. If the SRID is
+     * 4326 the geometry validity is already assured by libosmium, so we
+     * don't need it. And Point geometries are always valid.
      * No checks are needed for create_only columns, because they don't
      * contain anything.
      */
@@ -106,6 +123,9 @@ public:
 
     std::string const &type_name() const noexcept { return m_type_name; }
 
+    /// Has the SQL type of this column been set explicitly?
+    bool has_sql_type() const noexcept { return !m_sql_type.empty(); }
+
     bool not_null() const noexcept { return m_not_null; }
 
     bool create_only() const noexcept { return m_create_only; }
@@ -114,8 +134,46 @@ public:
 
     void set_create_only(bool value = true) noexcept { m_create_only = value; }
 
+    /**
+     * Write the keys of hstore columns in sorted order? Lua doesn't
+     * guarantee any order when iterating over tables, but for change
+     * detection the same data must always result in the same row.
+     */
+    bool sort_keys() const noexcept { return m_sort_keys; }
+
+    void set_sort_keys(bool value = true) noexcept { m_sort_keys = value; }
+
     void set_projection(char const *projection);
 
+    /**
+     * Is this column derived from the geometry in another column? The
+     * contents of derived columns are calculated in C++ when the row is
+     * written and not taken from the Lua row data.
+     */
+    bool is_derived() const noexcept
+    {
+        return m_derived_func != derived_column_func::none;
+    }
+
+    derived_column_func derived_func() const noexcept
+    {
+        return m_derived_func;
+    }
+
+    /// The index of the source column in the table (for derived columns).
+    std::size_t derived_from() const noexcept { return m_derived_from; }
+
+    /// The tolerance for the simplify function (for derived columns).
+    double tolerance() const noexcept { return m_tolerance; }
+
+    /**
+     * Make this a column derived from the specified source column using
+     * the function with the specified name. Throws if the function is
+     * unknown or doesn't fit the column type.
+     */
+    void set_derived(std::string const &func, std::size_t source,
+                     double tolerance);
+
     std::string sql_type_name() const;
     std::string sql_modifiers() const;
     std::string sql_create() const;
@@ -166,6 +224,18 @@ private:
 
     /// Column will be created but not filled by osm2pgsql.
     bool m_create_only = false;
+
+    /// Write keys of hstore column in sorted order.
+    bool m_sort_keys = false;
+
+    /// For derived columns: How the content is calculated.
+    derived_column_func m_derived_func = derived_column_func::none;
+
+    /// For derived columns: Index of the source column in the table.
+    std::size_t m_derived_from = 0;
+
+    /// For derived columns using the simplify function.
+    double m_tolerance = 0.0;
 };
 
 #endif // OSM2PGSQL_FLEX_TABLE_COLUMN_HPP
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <string>
 
 char const *type_to_char(osmium::item_type type) noexcept
@@ -176,27 +177,88 @@ std::string flex_table_t::build_sql_prepare_get_wkb() const
                        full_name(), id_column_names());
 }
 
-std::string
-flex_table_t::build_sql_create_table(table_type ttype,
-                                     std::string const &table_name) const
+std::string flex_table_t::build_sql_prepare_get_hashes() const
 {
-    assert(!m_columns.empty());
+    assert(m_detect_changes);
 
-    std::string sql =
-        fmt::format("CREATE {} TABLE IF NOT EXISTS {} (",
-                    ttype == table_type::interim ? "UNLOGGED" : "", table_name);
+    if (has_multicolumn_id_index()) {
+        return fmt::format(
+            R"(SELECT "{}" FROM {} WHERE "{}" = $1::char(1) AND "{}" = $2::bigint)",
+            HASH_COLUMN, full_name(), m_columns[0].name(), m_columns[1].name());
+    }
+
+    return fmt::format(R"(SELECT "{}" FROM {} WHERE "{}" = $1::bigint)",
+                       HASH_COLUMN, full_name(), id_column_names());
+}
+
+std::string flex_table_t::partition_name(std::size_t partition) const
+{
+    if (!partitioned()) {
+        return name();
+    }
+
+    assert(partition < num_partitions());
+    return fmt::format("{}_p{}", name(), partition);
+}
+
+std::string flex_table_t::build_sql_column_definitions(table_type ttype) const
+{
+    assert(!m_columns.empty());
 
     util::string_joiner_t joiner{','};
     for (auto const &column : m_columns) {
         // create_only columns are only created in permanent, not in the
         // interim tables
-        if (ttype == table_type::permanent || !column.create_only()) {
+        if (ttype != table_type::interim || !column.create_only()) {
             joiner.add(column.sql_create());
         }
     }
 
-    sql += joiner();
-    sql += ')';
+    return '(' + joiner() + ')';
+}
+
+std::string
+flex_table_t::build_sql_create_table(table_type ttype,
+                                     std::string const &table_name) const
+{
+    std::string sql =
+        fmt::format("CREATE {} TABLE IF NOT EXISTS {} {}",
+                    ttype == table_type::permanent ? "" : "UNLOGGED", table_name,
+                    build_sql_column_definitions(ttype));
+
+    if (ttype == table_type::interim) {
+        sql += " WITH (autovacuum_enabled = off)";
+    }
+
+    sql += tablespace_clause(m_data_tablespace);
+
+    return sql;
+}
+
+std::string flex_table_t::build_sql_create_partitioned_table() const
+{
+    assert(partitioned());
+
+    // The parent table never contains any data, so it is always created
+    // with all columns and without any storage options. Those are set on
+    // the partitions.
+    return fmt::format(
+        R"(CREATE TABLE IF NOT EXISTS {} {} PARTITION BY LIST ("{}"))",
+        full_name(), build_sql_column_definitions(table_type::permanent),
+        PARTITION_COLUMN);
+}
+
+std::string
+flex_table_t::build_sql_create_partition(table_type ttype,
+                                         std::size_t partition) const
+{
+    assert(partitioned());
+
+    std::string sql = fmt::format(
+        "CREATE {} TABLE IF NOT EXISTS {} PARTITION OF {} FOR VALUES IN ({})",
+        ttype == table_type::permanent ? "" : "UNLOGGED",
+        qualified_name(schema(), partition_name(partition)), full_name(),
+        partition);
 
     if (ttype == table_type::interim) {
         sql += " WITH (autovacuum_enabled = off)";
@@ -207,6 +269,13 @@ flex_table_t::build_sql_create_table(table_type ttype,
     return sql;
 }
 
+std::size_t flex_table_t::num_copy_columns() const noexcept
+{
+    return static_cast<std::size_t>(
+        std::count_if(m_columns.cbegin(), m_columns.cend(),
+                      [](auto const &column) { return !column.create_only(); }));
+}
+
 std::string flex_table_t::build_sql_column_list() const
 {
     assert(!m_columns.empty());
@@ -222,19 +291,21 @@ std::string flex_table_t::build_sql_column_list() const
     return joiner();
 }
 
-std::string flex_table_t::build_sql_create_id_index() const
+std::string flex_table_t::build_sql_create_id_index(
+    std::string const &qualified_table_name) const
 {
     if (m_primary_key_index) {
         auto ts = tablespace_clause(index_tablespace());
         if (!ts.empty()) {
             ts = " USING INDEX" + ts;
         }
-        return fmt::format("ALTER TABLE {} ADD PRIMARY KEY ({}){}", full_name(),
-                           id_column_names(), ts);
+        return fmt::format("ALTER TABLE {} ADD PRIMARY KEY ({}){}",
+                           qualified_table_name, id_column_names(), ts);
     }
 
     return fmt::format("CREATE {}INDEX ON {} USING BTREE ({}) {}",
-                       m_build_unique_id_index ? "UNIQUE " : "", full_name(),
+                       m_build_unique_id_index ? "UNIQUE " : "",
+                       qualified_table_name,
                        id_column_names(),
                        tablespace_clause(index_tablespace()));
 }
@@ -252,10 +323,19 @@ bool flex_table_t::has_columns_with_expire() const noexcept
 
 void flex_table_t::prepare(pg_conn_t const &db_connection) const
 {
+    if (m_ephemeral) {
+        return;
+    }
+
     if (has_id_column() && has_columns_with_expire()) {
         auto const stmt = fmt::format("get_wkb_{}", m_table_num);
         db_connection.prepare(stmt, fmt::runtime(build_sql_prepare_get_wkb()));
     }
+    if (has_id_column() && m_detect_changes) {
+        auto const stmt = fmt::format("get_hashes_{}", m_table_num);
+        db_connection.prepare(stmt,
+                              fmt::runtime(build_sql_prepare_get_hashes()));
+    }
 }
 
 void flex_table_t::analyze(pg_conn_t const &db_connection) const
@@ -265,126 +345,291 @@ void flex_table_t::analyze(pg_conn_t const &db_connection) const
 
 namespace {
 
-void enable_check_trigger(pg_conn_t const &db_connection,
-                          flex_table_t const &table)
+/**
+ * Older versions of osm2pgsql checked geometry validity in a trigger in the
+ * database. Remove those triggers, the check is done in osm2pgsql now.
+ */
+void drop_legacy_check_trigger(pg_conn_t const &db_connection,
+                               std::string const &schema,
+                               std::string const &table_name)
 {
-    std::string checks;
-
-    for (auto const &column : table.columns()) {
-        if (column.is_geometry_column() && column.needs_isvalid()) {
-            checks.append(fmt::format(
-                R"((NEW."{0}" IS NULL OR ST_IsValid(NEW."{0}")) AND )",
-                column.name()));
-        }
-    }
-
-    if (checks.empty()) {
-        return;
+    auto const result = db_connection.exec(
+        "SELECT 1 FROM pg_catalog.pg_trigger"
+        " WHERE tgrelid = '{}'::regclass AND tgname = '{}_osm2pgsql_valid'",
+        qualified_name(schema, table_name), table_name);
+
+    if (result.num_tuples() > 0) {
+        log_info("Removing geometry check trigger from table '{}'.",
+                 table_name);
+        drop_geom_check_trigger(db_connection, schema, table_name);
     }
-
-    // remove last " AND "
-    checks.resize(checks.size() - 5);
-
-    create_geom_check_trigger(db_connection, table.schema(), table.name(),
-                              checks);
 }
 
 } // anonymous namespace
 
-void table_connection_t::start(pg_conn_t const &db_connection,
-                               bool append) const
+void table_connection_t::start(pg_conn_t const &db_connection, bool append,
+                               bool unlogged)
 {
+    m_unlogged = unlogged;
+
+    if (table().ephemeral()) {
+        return;
+    }
+
     if (!append) {
         drop_table_if_exists(db_connection, table().schema(), table().name());
     }
 
     // These _tmp tables can be left behind if we run out of disk space.
-    drop_table_if_exists(db_connection, table().schema(),
-                         table().name() + "_tmp");
+    for (std::size_t n = 0; n < table().num_partitions(); ++n) {
+        drop_table_if_exists(db_connection, table().schema(),
+                             table().partition_name(n) + "_tmp");
+    }
 
     if (!append) {
-        db_connection.exec(table().build_sql_create_table(
-            table().cluster_by_geom() ? flex_table_t::table_type::interim
-                                      : flex_table_t::table_type::permanent,
-            table().full_name()));
+        auto ttype = flex_table_t::table_type::permanent;
+        if (table().cluster_by_geom()) {
+            ttype = flex_table_t::table_type::interim;
+        } else if (m_unlogged) {
+            ttype = flex_table_t::table_type::unlogged;
+        }
+
+        if (table().partitioned()) {
+            db_connection.exec(table().build_sql_create_partitioned_table());
+            for (std::size_t n = 0; n < table().num_partitions(); ++n) {
+                db_connection.exec(
+                    table().build_sql_create_partition(ttype, n));
+            }
+            create_partition_copy_mgrs();
+        } else {
+            db_connection.exec(
+                table().build_sql_create_table(ttype, table().full_name()));
+        }
 
-        enable_check_trigger(db_connection, table());
+        if (table().sort_by_geom()) {
+            m_row_sorter = std::make_unique<row_sorter_t>();
+        }
+    } else {
+        for (std::size_t n = 0; n < table().num_partitions(); ++n) {
+            drop_legacy_check_trigger(db_connection, table().schema(),
+                                      table().partition_name(n));
+        }
     }
 
     table().prepare(db_connection);
 }
 
-void table_connection_t::stop(pg_conn_t const &db_connection, bool updateable,
-                              bool append)
+void table_connection_t::create_partition_copy_mgrs()
+{
+    auto const num = table().num_partitions();
+
+    // The partitions share the buffer memory a table that is not partitioned
+    // would get, but each gets at least some minimum. This limits the memory
+    // use to 64 MB for the maximum of 256 partitions.
+    auto const buffer_size = std::max(MIN_PARTITION_COPY_BUFFER_SIZE,
+                                      db_cmd_copy_t::MAX_BUF_SIZE / num);
+
+    m_partition_targets.reserve(num);
+    m_partition_copy_mgrs.reserve(num);
+
+    for (std::size_t n = 0; n < num; ++n) {
+        auto &target =
+            m_partition_targets.emplace_back(std::make_shared<db_target_descr_t>(
+                table().schema(), table().partition_name(n),
+                table().id_column_names(), table().build_sql_column_list()));
+        if (m_target->binary()) {
+            target->set_binary(m_target->num_binary_columns());
+        }
+        m_partition_copy_mgrs.emplace_back(m_copy_thread, buffer_size);
+    }
+}
+
+void table_connection_t::new_line(quadkey_t key)
 {
+    // Rows collected for sorting are routed to their partitions later.
+    std::shared_ptr<db_target_descr_t> const *target = &m_target;
+    if (!m_partition_copy_mgrs.empty() && !sorting()) {
+        m_current_partition = table().partition_for(key);
+        target = &m_partition_targets[m_current_partition];
+    } else {
+        m_current_partition = m_partition_copy_mgrs.size();
+    }
+
+    if ((*target)->binary()) {
+        copy_mgr()->new_binary_line(*target);
+    } else {
+        copy_mgr()->new_line(*target);
+    }
+}
+
+void table_connection_t::finish_sorted_line(quadkey_t key)
+{
+    assert(m_row_sorter);
+    m_copy_mgr.take_line(&m_row_buffer);
+    m_row_sorter->add(key, m_row_buffer);
+}
+
+void table_connection_t::finish_line()
+{
+    auto *mgr = copy_mgr();
+    if (mgr != &m_copy_mgr && mgr->buffer_full()) {
+        send_pending_deletes();
+    }
+    mgr->finish_line();
+}
+
+void table_connection_t::send_pending_deletes()
+{
+    if (m_copy_mgr.has_pending_deletes()) {
+        m_copy_mgr.flush();
+    }
+}
+
+void table_connection_t::flush()
+{
+    m_copy_mgr.flush();
+    for (auto &copy_mgr : m_partition_copy_mgrs) {
+        copy_mgr.flush();
+    }
+}
+
+void table_connection_t::sync()
+{
+    if (m_row_sorter) {
+        write_sorted_rows();
+    }
+    if (!m_partition_copy_mgrs.empty()) {
+        send_pending_deletes();
+        for (auto &copy_mgr : m_partition_copy_mgrs) {
+            copy_mgr.flush();
+        }
+    }
     m_copy_mgr.sync();
+}
 
-    if (append) {
-        return;
+void table_connection_t::write_sorted_rows()
+{
+    assert(m_row_sorter);
+
+    log_info("Writing {} rows sorted by geometry to table '{}'...",
+             m_row_sorter->size(), table().name());
+
+    if (!m_partition_copy_mgrs.empty()) {
+        send_pending_deletes();
     }
 
-    if (table().cluster_by_geom()) {
-        if (table().geom_column().needs_isvalid()) {
-            drop_geom_check_trigger(db_connection, table().schema(),
-                                    table().name());
+    m_row_sorter->drain([&](quadkey_t key, std::string_view row) {
+        if (m_partition_copy_mgrs.empty()) {
+            m_copy_mgr.add_line(m_target, row);
+        } else {
+            auto const partition = table().partition_for(key);
+            m_partition_copy_mgrs[partition].add_line(
+                m_partition_targets[partition], row);
         }
+    });
+    m_row_sorter.reset();
+}
+
+void table_connection_t::cluster(pg_conn_t const &db_connection,
+                                 std::size_t partition)
+{
+    if (!table().cluster_by_geom()) {
+        return;
+    }
 
-        log_info("Clustering table '{}' by geometry...", table().name());
+    auto const name = table().partition_name(partition);
+    auto const full_name = qualified_name(table().schema(), name);
+    auto const full_tmp_name = qualified_name(table().schema(), name + "_tmp");
 
-        db_connection.exec(table().build_sql_create_table(
-            flex_table_t::table_type::permanent, table().full_tmp_name()));
+    log_info("Clustering table '{}' by geometry...", name);
 
-        std::string const columns = table().build_sql_column_list();
+    // The clustered copy is always created as a normal (logged) table, even
+    // with --unlogged, because it has to be written completely anyway.
+    db_connection.exec(table().build_sql_create_table(
+        flex_table_t::table_type::permanent, full_tmp_name));
 
-        auto const geom_column_name =
-            "\"" + table().geom_column().name() + "\"";
+    std::string const columns = table().build_sql_column_list();
 
-        std::string const sql =
-            fmt::format("INSERT INTO {} ({}) SELECT {} FROM {} ORDER BY {}",
-                        table().full_tmp_name(), columns, columns,
-                        table().full_name(), geom_column_name);
+    auto const geom_column_name = "\"" + table().geom_column().name() + "\"";
 
-        db_connection.exec(sql);
+    std::string const sql =
+        fmt::format("INSERT INTO {} ({}) SELECT {} FROM {} ORDER BY {}",
+                    full_tmp_name, columns, columns, full_name,
+                    geom_column_name);
 
-        db_connection.exec("DROP TABLE {}", table().full_name());
-        db_connection.exec(R"(ALTER TABLE {} RENAME TO "{}")",
-                           table().full_tmp_name(), table().name());
-        m_id_index_created = false;
+    db_connection.exec(sql);
 
-        if (updateable) {
-            enable_check_trigger(db_connection, table());
-        }
+    if (table().partitioned()) {
+        // With this constraint in place attaching the new partition doesn't
+        // need to scan it.
+        db_connection.exec(
+            R"(ALTER TABLE {} ADD CONSTRAINT "{}_check" CHECK ("{}" = {}))",
+            full_tmp_name, name, flex_table_t::PARTITION_COLUMN, partition);
     }
 
-    if (table().indexes().empty()) {
-        log_info("No indexes to create on table '{}'.", table().name());
-    } else {
-        for (auto const &index : table().indexes()) {
-            log_info("Creating index on table '{}' {}...", table().name(),
-                     index.columns());
-            auto const sql = index.create_index(
-                qualified_name(table().schema(), table().name()));
-            db_connection.exec(sql);
-        }
+    db_connection.exec("DROP TABLE {}", full_name);
+    db_connection.exec(R"(ALTER TABLE {} RENAME TO "{}")", full_tmp_name,
+                       name);
+
+    if (table().partitioned()) {
+        db_connection.exec("ALTER TABLE {} ATTACH PARTITION {}"
+                           " FOR VALUES IN ({})",
+                           table().full_name(), full_name, partition);
+        db_connection.exec(R"(ALTER TABLE {} DROP CONSTRAINT "{}_check")",
+                           full_name, name);
     }
 
-    if ((table().always_build_id_index() || updateable) &&
-        table().has_id_column()) {
-        create_id_index(db_connection);
+    m_id_index_created[partition] = false;
+}
+
+void table_connection_t::set_logged(pg_conn_t const &db_connection,
+                                    std::size_t partition) const
+{
+    // Tables clustered by geometry are already logged, see cluster().
+    if (!m_unlogged || table().cluster_by_geom()) {
+        return;
     }
 
+    auto const name = table().partition_name(partition);
+    log_info("Setting table '{}' to LOGGED...", name);
+    db_connection.exec("ALTER TABLE {} SET LOGGED",
+                       qualified_name(table().schema(), name));
+}
+
+void table_connection_t::create_index(pg_conn_t const &db_connection,
+                                      flex_index_t const &index,
+                                      std::size_t partition) const
+{
+    auto const name = table().partition_name(partition);
+    log_info("Creating index on table '{}' {}...", name, index.columns());
+    db_connection.exec(
+        index.create_index(qualified_name(table().schema(), name)));
+}
+
+void table_connection_t::analyze(pg_conn_t const &db_connection) const
+{
     log_info("Analyzing table '{}'...", table().name());
     table().analyze(db_connection);
 }
 
 void table_connection_t::create_id_index(pg_conn_t const &db_connection)
 {
-    if (m_id_index_created) {
-        log_debug("Id index on table '{}' already created.", table().name());
+    for (std::size_t n = 0; n < table().num_partitions(); ++n) {
+        create_id_index(db_connection, n);
+    }
+}
+
+void table_connection_t::create_id_index(pg_conn_t const &db_connection,
+                                         std::size_t partition)
+{
+    auto const name = table().partition_name(partition);
+    if (m_id_index_created[partition]) {
+        log_debug("Id index on table '{}' already created.", name);
     } else {
-        log_info("Creating id index on table '{}'...", table().name());
-        db_connection.exec(table().build_sql_create_id_index());
-        m_id_index_created = true;
+        log_info("Creating id index on table '{}'...", name);
+        db_connection.exec(table().build_sql_create_id_index(
+            qualified_name(table().schema(), name)));
+        m_id_index_created[partition] = true;
     }
 }
 
@@ -401,8 +646,75 @@ pg_result_t table_connection_t::get_geoms_by_id(pg_conn_t const &db_connection,
     return db_connection.exec_prepared_as_binary(stmt.c_str(), id);
 }
 
+void table_connection_t::start_change_detection(
+    pg_conn_t const &db_connection, osmium::item_type type, osmid_t osm_id)
+{
+    assert(!m_detecting_changes);
+
+    auto const id = table().map_id(type, osm_id);
+    std::string const stmt = fmt::format("get_hashes_{}", table().num());
+    auto const result =
+        table().has_multicolumn_id_index()
+            ? db_connection.exec_prepared(stmt.c_str(), type_to_char(type), id)
+            : db_connection.exec_prepared(stmt.c_str(), id);
+
+    m_old_hashes.clear();
+    for (int i = 0; i < result.num_tuples(); ++i) {
+        m_old_hashes.push_back(
+            std::strtoll(result.get_value(i, 0), nullptr, 10));
+    }
+
+    m_num_held_rows = 0;
+    m_detect_type = type;
+    m_detect_id = osm_id;
+    m_detecting_changes = true;
+    m_rows_changed = false;
+}
+
+void table_connection_t::hold_line(int64_t hash)
+{
+    assert(m_detecting_changes);
+
+    if (m_num_held_rows == m_held_rows.size()) {
+        m_held_rows.emplace_back();
+    }
+    copy_mgr()->take_line(&m_held_rows[m_num_held_rows]);
+    ++m_num_held_rows;
+
+    auto const it = std::find(m_old_hashes.begin(), m_old_hashes.end(), hash);
+    if (it == m_old_hashes.end()) {
+        m_rows_changed = true;
+    } else {
+        *it = m_old_hashes.back();
+        m_old_hashes.pop_back();
+    }
+}
+
+void table_connection_t::finish_change_detection()
+{
+    assert(m_detecting_changes);
+
+    if (has_changes()) {
+        for (std::size_t i = 0; i < m_num_held_rows; ++i) {
+            m_copy_mgr.add_line(m_target, m_held_rows[i]);
+        }
+    } else {
+        m_count_unchanged += m_num_held_rows;
+    }
+
+    m_num_held_rows = 0;
+    m_old_hashes.clear();
+    m_detecting_changes = false;
+}
+
 void table_connection_t::delete_rows_with(osmium::item_type type, osmid_t id)
 {
+    // Rows still waiting to be sorted would not be deleted, so write them
+    // out now. Usually this has already happened in sync().
+    if (m_row_sorter) {
+        write_sorted_rows();
+    }
+
     m_copy_mgr.new_line(m_target);
 
     if (!table().has_multicolumn_id_index()) {
@@ -411,12 +723,32 @@ void table_connection_t::delete_rows_with(osmium::item_type type, osmid_t id)
     m_copy_mgr.delete_object(type_to_char(type)[0], id);
 }
 
+std::vector<std::shared_future<std::chrono::microseconds>>
+table_connection_t::task_futures() const
+{
+    std::vector<std::shared_future<std::chrono::microseconds>> futures;
+    futures.reserve(m_task_results.size());
+
+    for (auto const &task_result : m_task_results) {
+        futures.push_back(task_result.future());
+    }
+
+    return futures;
+}
+
 void table_connection_t::task_wait()
 {
-    auto const run_time = m_task_result.wait();
-    log_info("All postprocessing on table '{}' done in {}.", table().name(),
+    auto const run_time = wait_for_tasks(&m_task_results);
+    log_info("All postprocessing on table '{}' done ({} tasks taking {}"
+             " in total).",
+             table().name(), m_task_results.size(),
              util::human_readable_duration(run_time));
     log_debug("Inserted {} rows into table '{}' ({} not inserted due to"
-              " NOT NULL constraints).",
-              m_count_insert, table().name(), m_count_not_null_error);
+              " NOT NULL constraints, {} due to invalid geometries).",
+              m_count_insert, table().name(), m_count_not_null_error,
+              m_count_invalid_geometry);
+    if (table().detect_changes()) {
+        log_debug("Skipped {} unchanged rows in table '{}'.",
+                  m_count_unchanged, table().name());
+    }
 }
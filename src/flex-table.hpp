@@ -16,11 +16,13 @@
 #include "pgsql.hpp"
 #include "projection.hpp"
 #include "reprojection.hpp"
+#include "row-sorter.hpp"
 #include "thread-pool.hpp"
 #include "util.hpp"
 
 #include <osmium/osm/item_type.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -57,14 +59,33 @@ class flex_table_t
 public:
     /**
      * Table creation type: interim tables are created as UNLOGGED and with
-     * autovacuum disabled.
+     * autovacuum disabled. Unlogged tables are permanent tables which are
+     * created as UNLOGGED and set to LOGGED after import.
      */
     enum class table_type : uint8_t
     {
         interim,
+        unlogged,
         permanent
     };
 
+    /**
+     * Zoom level of the tiles used for the keys calculated from the
+     * geometry of a row (see flex_sort_key()) which are used for sorting
+     * and partitioning. This is detailed enough to get a good spatial order
+     * without making the keys needlessly large.
+     */
+    static constexpr uint32_t GEOM_KEY_ZOOM = 24;
+
+    /// Maximum zoom level allowed for partitioning by tile.
+    static constexpr uint32_t MAX_PARTITION_ZOOM = 4;
+
+    /// Name of the column containing the partition number.
+    static constexpr char const *const PARTITION_COLUMN = "partition";
+
+    /// Name of the column containing the hash used for change detection.
+    static constexpr char const *const HASH_COLUMN = "row_hash";
+
     flex_table_t(std::string schema, std::string name, std::size_t num)
     : m_schema(std::move(schema)), m_name(std::move(name)), m_table_num(num)
     {
@@ -79,6 +100,11 @@ public:
         return has_geom_column() && m_cluster_by_geom;
     }
 
+    bool sort_by_geom() const noexcept
+    {
+        return has_geom_column() && m_sort_by_geom;
+    }
+
     std::string const &data_tablespace() const noexcept
     {
         return m_data_tablespace;
@@ -99,6 +125,76 @@ public:
         m_cluster_by_geom = cluster;
     }
 
+    void set_sort_by_geom(bool sort) noexcept { m_sort_by_geom = sort; }
+
+    /// Use the binary COPY format when sending data to the database?
+    bool binary_copy() const noexcept { return m_binary_copy; }
+
+    void set_binary_copy(bool binary) noexcept { m_binary_copy = binary; }
+
+    /**
+     * Detect changes in append mode? If this is set, a hash of the row
+     * contents is stored with each row. When an object changes, its rows
+     * are only deleted and written again if they are actually different.
+     */
+    bool detect_changes() const noexcept { return m_detect_changes; }
+
+    void set_detect_changes(bool detect) noexcept { m_detect_changes = detect; }
+
+    /**
+     * Is this an ephemeral table? Rows inserted into ephemeral tables are
+     * never sent to the database, no table is created for them. They are
+     * only used in osm2pgsql itself, currently for expiring tiles. Because
+     * the old geometries are not stored anywhere, only the tiles of new
+     * geometries are expired in append mode, not those of the geometries
+     * of changed or deleted objects.
+     */
+    bool ephemeral() const noexcept { return m_ephemeral; }
+
+    void set_ephemeral(bool ephemeral) noexcept { m_ephemeral = ephemeral; }
+
+    /// The number of columns filled by osm2pgsql (not create_only).
+    std::size_t num_copy_columns() const noexcept;
+
+    /**
+     * Is this table partitioned by tile? Each partition contains the rows
+     * with geometries which have the center of their bounding box in one
+     * tile on zoom level partition_zoom().
+     */
+    bool partitioned() const noexcept { return m_partition_zoom > 0; }
+
+    uint32_t partition_zoom() const noexcept { return m_partition_zoom; }
+
+    void set_partition_zoom(uint32_t zoom) noexcept
+    {
+        assert(zoom <= MAX_PARTITION_ZOOM);
+        m_partition_zoom = zoom;
+    }
+
+    /// The number of partitions (1 if the table isn't partitioned).
+    std::size_t num_partitions() const noexcept
+    {
+        return std::size_t{1} << (2U * m_partition_zoom);
+    }
+
+    /**
+     * The name of the specified partition. If the table isn't partitioned
+     * this is the name of the table itself.
+     */
+    std::string partition_name(std::size_t partition) const;
+
+    /**
+     * The partition a row belongs in given the key calculated from its
+     * geometry. Rows without geometry go into the last partition.
+     */
+    std::size_t partition_for(quadkey_t key) const noexcept
+    {
+        auto const partition =
+            key.down(GEOM_KEY_ZOOM - m_partition_zoom).value();
+        return static_cast<std::size_t>(
+            std::min<uint64_t>(partition, num_partitions() - 1));
+    }
+
     void set_data_tablespace(std::string tablespace) noexcept
     {
         m_data_tablespace = std::move(tablespace);
@@ -122,6 +218,8 @@ public:
         return m_columns;
     }
 
+    std::vector<flex_table_column_t> &columns() noexcept { return m_columns; }
+
     flex_table_column_t *find_column_by_name(std::string const &name)
     {
         return util::find_by_name(m_columns, name);
@@ -152,12 +250,22 @@ public:
 
     std::string build_sql_prepare_get_wkb() const;
 
+    std::string build_sql_prepare_get_hashes() const;
+
     std::string build_sql_create_table(table_type ttype,
                                        std::string const &table_name) const;
 
+    /// Create the parent table of a partitioned table.
+    std::string build_sql_create_partitioned_table() const;
+
+    /// Create the specified partition of a partitioned table.
+    std::string build_sql_create_partition(table_type ttype,
+                                           std::size_t partition) const;
+
     std::string build_sql_column_list() const;
 
-    std::string build_sql_create_id_index() const;
+    std::string
+    build_sql_create_id_index(std::string const &qualified_table_name) const;
 
     /// Does this table take objects of the specified type?
     bool matches_type(osmium::item_type type) const noexcept;
@@ -216,6 +324,9 @@ public:
     void analyze(pg_conn_t const &db_connection) const;
 
 private:
+    /// Column definitions for CREATE TABLE including the parentheses.
+    std::string build_sql_column_definitions(table_type ttype) const;
+
     /// The schema this table is in
     std::string m_schema;
 
@@ -259,6 +370,24 @@ private:
     /// Cluster the table by geometry.
     bool m_cluster_by_geom = true;
 
+    /**
+     * Sort rows by geometry in osm2pgsql before sending them to the database
+     * on import (instead of clustering the table in the database).
+     */
+    bool m_sort_by_geom = false;
+
+    /// Zoom level of the tiles the table is partitioned by (0 = none).
+    uint32_t m_partition_zoom = 0;
+
+    /// Use the binary COPY format instead of the text format.
+    bool m_binary_copy = false;
+
+    /// Store row hashes and use them to detect unchanged rows on update.
+    bool m_detect_changes = false;
+
+    /// Rows are not stored in the database.
+    bool m_ephemeral = false;
+
     /// Does this table have more than one geometry column?
     bool m_has_multiple_geom_columns = false;
 
@@ -282,18 +411,64 @@ public:
       m_target(std::make_shared<db_target_descr_t>(
           table->schema(), table->name(), table->id_column_names(),
           table->build_sql_column_list())),
-      m_copy_mgr(copy_thread)
+      m_copy_thread(copy_thread), m_copy_mgr(copy_thread),
+      m_id_index_created(table->num_partitions(), false)
     {
+        if (table->binary_copy()) {
+            m_target->set_binary(
+                static_cast<uint16_t>(table->num_copy_columns()));
+        }
     }
 
-    void start(pg_conn_t const &db_connection, bool append) const;
+    /**
+     * Set up the table in the database.
+     *
+     * \param db_connection The database connection to use.
+     * \param append Are we in append mode?
+     * \param unlogged Create the table as UNLOGGED and keep it that way
+     *                 until set_logged() is called.
+     */
+    void start(pg_conn_t const &db_connection, bool append, bool unlogged);
+
+    /**
+     * Cluster the specified partition of the table by geometry (part of
+     * post-processing). Call sync() before this.
+     */
+    void cluster(pg_conn_t const &db_connection, std::size_t partition);
+
+    /**
+     * Set the specified partition of the table to LOGGED if it was created
+     * as UNLOGGED and not clustered (part of post-processing).
+     */
+    void set_logged(pg_conn_t const &db_connection,
+                    std::size_t partition) const;
+
+    /**
+     * Create the specified index on the specified partition of the table
+     * (part of post-processing). Partitioned tables only get indexes on the
+     * partitions, not on the parent table.
+     */
+    void create_index(pg_conn_t const &db_connection,
+                      flex_index_t const &index, std::size_t partition) const;
 
-    void stop(pg_conn_t const &db_connection, bool updateable, bool append);
+    /// Analyze the table (last step of post-processing).
+    void analyze(pg_conn_t const &db_connection) const;
 
     flex_table_t const &table() const noexcept { return *m_table; }
 
+    /// Does the table need an id index after import?
+    bool needs_id_index(bool updateable) const noexcept
+    {
+        return (table().always_build_id_index() || updateable) &&
+               table().has_id_column() && !table().ephemeral();
+    }
+
+    /// Create the id index on all partitions of the table.
     void create_id_index(pg_conn_t const &db_connection);
 
+    /// Create the id index on the specified partition of the table.
+    void create_id_index(pg_conn_t const &db_connection, std::size_t partition);
+
     /**
      * Get all geometries that have at least one expire config defined
      * from the database and return the result set.
@@ -301,14 +476,89 @@ public:
     pg_result_t get_geoms_by_id(pg_conn_t const &db_connection,
                                 osmium::item_type type, osmid_t id) const;
 
-    void flush() { m_copy_mgr.flush(); }
+    /**
+     * Start detecting changes for the specified object. Instead of deleting
+     * the rows of the object, the hashes of the rows currently in the
+     * database are remembered. Rows added for the object are held back
+     * (see hold_line()) until finish_change_detection() is called.
+     */
+    void start_change_detection(pg_conn_t const &db_connection,
+                                osmium::item_type type, osmid_t osm_id);
+
+    bool detecting_changes() const noexcept { return m_detecting_changes; }
+
+    /// Type of the object changes are detected for.
+    osmium::item_type detect_type() const noexcept { return m_detect_type; }
+
+    /// Id of the object changes are detected for.
+    osmid_t detect_id() const noexcept { return m_detect_id; }
+
+    /**
+     * Finish the current row, but hold it back instead of sending it to
+     * the database. The hash of the row is compared to the hashes of the
+     * rows in the database.
+     *
+     * \pre \code detecting_changes() \endcode
+     */
+    void hold_line(int64_t hash);
+
+    /**
+     * Are the rows added for the object different from the rows in the
+     * database?
+     */
+    bool has_changes() const noexcept
+    {
+        return m_rows_changed || !m_old_hashes.empty();
+    }
+
+    /**
+     * Finish change detection. If there are changes, the rows held back
+     * are sent to the database. The caller has to delete the old rows
+     * before that. Otherwise the rows held back are discarded.
+     */
+    void finish_change_detection();
+
+    void flush();
+
+    /**
+     * Make sure all rows are in the database. This also writes out any rows
+     * collected for sorting, so rows added afterwards are not sorted.
+     */
+    void sync();
+
+    /**
+     * Start a new row. The key calculated from the geometry of the row is
+     * only needed for partitioned tables.
+     */
+    void new_line(quadkey_t key = {});
 
-    void sync() { m_copy_mgr.sync(); }
+    /**
+     * Are rows collected and sorted by geometry before they are sent to the
+     * database?
+     */
+    bool sorting() const noexcept { return m_row_sorter != nullptr; }
 
-    void new_line() { m_copy_mgr.new_line(m_target); }
+    /**
+     * Finish the current row, but instead of sending it to the database
+     * keep it for sorting.
+     *
+     * \pre \code sorting() \endcode
+     */
+    void finish_sorted_line(quadkey_t key);
 
+    /**
+     * Finish the current row. If it goes into a partition and fills up
+     * the buffer for that partition, deletes still pending on the parent
+     * table are sent first, see send_pending_deletes().
+     */
+    void finish_line();
+
+    /// The copy manager the current row is written to.
     db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr() noexcept
     {
+        if (m_current_partition < m_partition_copy_mgrs.size()) {
+            return &m_partition_copy_mgrs[m_current_partition];
+        }
         return &m_copy_mgr;
     }
 
@@ -320,11 +570,26 @@ public:
         return *m_proj;
     }
 
-    void task_set(std::future<std::chrono::microseconds> &&future)
+    /**
+     * Add a post-processing task for this table. Returns a future other
+     * tasks can use to wait for this task to finish.
+     */
+    std::shared_future<std::chrono::microseconds>
+    task_add(std::future<std::chrono::microseconds> &&future)
     {
-        m_task_result.set(std::move(future));
+        auto &task_result = m_task_results.emplace_back();
+        task_result.set(std::move(future));
+        return task_result.future();
     }
 
+    /**
+     * Get futures for all post-processing tasks added so far. Tasks added
+     * later can use them to wait for the earlier tasks to finish.
+     */
+    std::vector<std::shared_future<std::chrono::microseconds>>
+    task_futures() const;
+
+    /// Wait for all post-processing tasks of this table to finish.
     void task_wait();
 
     void increment_insert_counter() noexcept { ++m_count_insert; }
@@ -334,6 +599,11 @@ public:
         ++m_count_not_null_error;
     }
 
+    void increment_invalid_geometry_counter() noexcept
+    {
+        ++m_count_invalid_geometry;
+    }
+
 private:
     std::shared_ptr<reprojection_t> m_proj;
 
@@ -341,19 +611,85 @@ private:
 
     std::shared_ptr<db_target_descr_t> m_target;
 
+    std::shared_ptr<db_copy_thread_t> m_copy_thread;
+
     /**
      * The copy manager responsible for sending data through the COPY mechanism
      * to the database server.
      */
     db_copy_mgr_t<db_deleter_by_type_and_id_t> m_copy_mgr;
 
-    task_result_t m_task_result;
+    /**
+     * Deletes in append mode always go through the parent table, because
+     * the partition the old row is in is not known. They must reach the
+     * database before any partition buffer with rows added after them,
+     * otherwise they would remove those new rows, too.
+     */
+    void send_pending_deletes();
+
+    /// Minimum size of the COPY buffer for each partition.
+    static constexpr std::size_t MIN_PARTITION_COPY_BUFFER_SIZE =
+        256UL * 1024UL;
+
+    /**
+     * When importing into a partitioned table, rows are sent directly to
+     * the partitions instead of through the parent table. Each partition
+     * has its own copy manager, so rows for different partitions don't
+     * interrupt each other's COPY buffers. The buffers are smaller than
+     * usual, see create_partition_copy_mgrs(). These are empty otherwise.
+     */
+    std::vector<std::shared_ptr<db_target_descr_t>> m_partition_targets;
+    std::vector<db_copy_mgr_t<db_deleter_by_type_and_id_t>>
+        m_partition_copy_mgrs;
+
+    /// The partition the current row is written to (if routing rows).
+    std::size_t m_current_partition = 0;
+
+    /// Is the table created as UNLOGGED until set_logged() is called?
+    bool m_unlogged = false;
+
+    std::vector<task_result_t> m_task_results;
+
+    /// Collects rows when sorting by geometry (otherwise nullptr).
+    std::unique_ptr<row_sorter_t> m_row_sorter;
+
+    /// Buffer for a single row when sorting (reused).
+    std::string m_row_buffer;
+
+    /// Hashes of rows in the database not (yet) matched by a new row.
+    std::vector<int64_t> m_old_hashes;
+
+    /// Rows held back while detecting changes.
+    std::vector<std::string> m_held_rows;
+
+    /// Number of rows in m_held_rows that are in use.
+    std::size_t m_num_held_rows = 0;
+
+    osmium::item_type m_detect_type = osmium::item_type::undefined;
+    osmid_t m_detect_id = 0;
+
+    bool m_detecting_changes = false;
+
+    /// Has any row been added that is not in the database already?
+    bool m_rows_changed = false;
 
     std::size_t m_count_insert = 0;
     std::size_t m_count_not_null_error = 0;
+    std::size_t m_count_invalid_geometry = 0;
+    std::size_t m_count_unchanged = 0;
+
+    /**
+     * Has the Id index already been created (for each partition)? This is
+     * not a std::vector<bool> because the entries are set from different
+     * threads.
+     */
+    std::vector<char> m_id_index_created;
+
+    /// Send all rows collected for sorting to the database in order.
+    void write_sorted_rows();
 
-    /// Has the Id index already been created?
-    bool m_id_index_created = false;
+    /// Set up sending rows directly to the partitions of the table.
+    void create_partition_copy_mgrs();
 
 }; // class table_connection_t
 
@@ -0,0 +1,79 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "flex-tag-filter.hpp"
+
+#include "format.hpp"
+#include "wildcmp.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+bool flex_tag_filter_t::pattern_t::matches(
+    osmium::Tag const &tag) const noexcept
+{
+    if (literal_key) {
+        if (std::strcmp(key.c_str(), tag.key()) != 0) {
+            return false;
+        }
+    } else if (!wild_match(key.c_str(), tag.key())) {
+        return false;
+    }
+
+    return any_value || wild_match(value.c_str(), tag.value());
+}
+
+void flex_tag_filter_t::enable(osmium::item_type type)
+{
+    m_enabled[osmium::item_type_to_nwr_index(type)] = true;
+}
+
+void flex_tag_filter_t::add(osmium::item_type type, std::string_view pattern)
+{
+    pattern_t p;
+
+    auto const pos = pattern.find('=');
+    if (pos == std::string_view::npos) {
+        p.key = pattern;
+        p.any_value = true;
+    } else {
+        p.key = pattern.substr(0, pos);
+        p.value = pattern.substr(pos + 1);
+    }
+
+    if (p.key.empty()) {
+        throw fmt_error("Invalid pattern '{}' in tag filter: Key is empty.",
+                        pattern);
+    }
+
+    p.literal_key = p.key.find_first_of("*?") == std::string::npos;
+
+    enable(type);
+    m_patterns[osmium::item_type_to_nwr_index(type)].push_back(std::move(p));
+}
+
+bool flex_tag_filter_t::matches(osmium::item_type type,
+                                osmium::TagList const &tags) const noexcept
+{
+    auto const index = osmium::item_type_to_nwr_index(type);
+    if (!m_enabled[index]) {
+        return true;
+    }
+
+    auto const &patterns = m_patterns[index];
+    return std::any_of(tags.cbegin(), tags.cend(),
+                       [&](osmium::Tag const &tag) {
+                           return std::any_of(patterns.cbegin(),
+                                              patterns.cend(),
+                                              [&](pattern_t const &p) {
+                                                  return p.matches(tag);
+                                              });
+                       });
+}
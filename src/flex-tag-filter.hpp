@@ -0,0 +1,78 @@
+#ifndef OSM2PGSQL_FLEX_TAG_FILTER_HPP
+#define OSM2PGSQL_FLEX_TAG_FILTER_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/tag.hpp>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A filter on the tags of OSM objects declared in the Lua config. It is
+ * used to decide whether a tagged object needs to be passed to the Lua
+ * process callbacks at all.
+ *
+ * For each object type (node, way, relation) a list of patterns can be set.
+ * A pattern is either just a key or a key and a value separated by an equal
+ * sign. Keys and values can contain the wildcards '*' and '?' (see
+ * wild_match()). An object matches if any of its tags matches any of the
+ * patterns. If the filter is not enabled for an object type, all objects
+ * of that type match.
+ */
+class flex_tag_filter_t
+{
+public:
+    /// Enable the filter for this object type without adding any patterns.
+    void enable(osmium::item_type type);
+
+    /// Add a pattern for this object type. This also enables the filter.
+    void add(osmium::item_type type, std::string_view pattern);
+
+    bool enabled(osmium::item_type type) const noexcept
+    {
+        return m_enabled[osmium::item_type_to_nwr_index(type)];
+    }
+
+    /// Does an object of the specified type with these tags match?
+    bool matches(osmium::item_type type,
+                 osmium::TagList const &tags) const noexcept;
+
+    /// The number of patterns for the specified type.
+    std::size_t num_patterns(osmium::item_type type) const noexcept
+    {
+        return m_patterns[osmium::item_type_to_nwr_index(type)].size();
+    }
+
+private:
+    struct pattern_t
+    {
+        std::string key;
+        std::string value;
+
+        /// Key has no wildcards, so a simple string compare is enough.
+        bool literal_key = false;
+
+        /// Pattern only contains a key, any value matches.
+        bool any_value = false;
+
+        bool matches(osmium::Tag const &tag) const noexcept;
+    };
+
+    std::array<std::vector<pattern_t>, 3> m_patterns;
+    std::array<bool, 3> m_enabled{};
+
+}; // class flex_tag_filter_t
+
+#endif // OSM2PGSQL_FLEX_TAG_FILTER_HPP
@@ -9,17 +9,23 @@
 
 #include "flex-lua-geom.hpp"
 #include "flex-write.hpp"
+#include "geom-box.hpp"
 #include "geom-functions.hpp"
 #include "json-writer.hpp"
 #include "lua-utils.hpp"
+#include "reprojection.hpp"
 #include "wkb.hpp"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -35,8 +41,7 @@ int sgn(double val) noexcept
     return 0;
 }
 
-void write_null(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
-                flex_table_column_t const &column)
+void check_not_null(flex_table_column_t const &column)
 {
     if (column.not_null()) {
         throw not_null_exception_t{
@@ -44,7 +49,48 @@ void write_null(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
                         column.name()),
             &column};
     }
-    copy_mgr->add_null_column();
+}
+
+void write_null(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                flex_table_column_t const &column)
+{
+    check_not_null(column);
+    if (copy_mgr->binary()) {
+        copy_mgr->add_binary_null_column();
+    } else {
+        copy_mgr->add_null_column();
+    }
+}
+
+void write_bool_value(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                      bool value)
+{
+    if (copy_mgr->binary()) {
+        copy_mgr->add_binary_column(value);
+    } else {
+        copy_mgr->add_column(value);
+    }
+}
+
+void write_real_value(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                      double value)
+{
+    if (copy_mgr->binary()) {
+        // Database type "real" is a 4-byte floating point number.
+        copy_mgr->add_binary_column(static_cast<float>(value));
+    } else {
+        copy_mgr->add_column(value);
+    }
+}
+
+void write_geom_value(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                      std::string const &wkb)
+{
+    if (copy_mgr->binary()) {
+        copy_mgr->add_binary_column(wkb);
+    } else {
+        copy_mgr->add_hex_geom(wkb);
+    }
 }
 
 void write_boolean(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
@@ -52,13 +98,13 @@ void write_boolean(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
 {
     if ((std::strcmp(str, "yes") == 0) || (std::strcmp(str, "true") == 0) ||
         std::strcmp(str, "1") == 0) {
-        copy_mgr->add_column(true);
+        write_bool_value(copy_mgr, true);
         return;
     }
 
     if ((std::strcmp(str, "no") == 0) || (std::strcmp(str, "false") == 0) ||
         std::strcmp(str, "0") == 0) {
-        copy_mgr->add_column(false);
+        write_bool_value(copy_mgr, false);
         return;
     }
 
@@ -69,17 +115,17 @@ void write_direction(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
                      flex_table_column_t const &column, char const *str)
 {
     if ((std::strcmp(str, "yes") == 0) || (std::strcmp(str, "1") == 0)) {
-        copy_mgr->add_column(1);
+        flex_write_integer(copy_mgr, column, 1);
         return;
     }
 
     if ((std::strcmp(str, "no") == 0) || (std::strcmp(str, "0") == 0)) {
-        copy_mgr->add_column(0);
+        flex_write_integer(copy_mgr, column, 0);
         return;
     }
 
     if (std::strcmp(str, "-1") == 0) {
-        copy_mgr->add_column(-1);
+        flex_write_integer(copy_mgr, column, -1);
         return;
     }
 
@@ -106,7 +152,7 @@ void write_integer(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
 
     if (value >= std::numeric_limits<T>::min() &&
         value <= std::numeric_limits<T>::max()) {
-        copy_mgr->add_column(value);
+        flex_write_integer(copy_mgr, column, value);
         return;
     }
 
@@ -129,7 +175,7 @@ void write_double(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
         return;
     }
 
-    copy_mgr->add_column(value);
+    write_real_value(copy_mgr, value);
 }
 
 using table_register_type = std::vector<void const *>;
@@ -253,8 +299,127 @@ bool is_compatible(geom::geometry_t const &geom,
     return false;
 }
 
+/**
+ * Transform geometry into the projection with the given srid. The result
+ * is stored in a geometry reused for all calls in this thread, so the
+ * memory for it doesn't have to be allocated again for every object. It
+ * is only valid until the next call of this function.
+ *
+ * Memory is never given back: The thread_local scratch geometry keeps the
+ * capacity of the largest geometry seen for the lifetime of the thread.
+ */
+geom::geometry_t const &transform_reusing(geom::geometry_t const &geom,
+                                          int srid)
+{
+    static thread_local geom::geometry_t tgeom;
+    geom::transform(&tgeom, geom, get_projection(srid));
+    return tgeom;
+}
+
+/**
+ * Write geometry into a geometry column. The geometry must already be in
+ * the projection of the column.
+ */
+void check_geometry(flex_table_column_t const &column,
+                    geom::geometry_t const &geom)
+{
+    assert(geom.srid() == column.srid());
+
+    if (!is_compatible(geom, column.type())) {
+        throw fmt_error("Geometry data for geometry column '{}'"
+                        " has the wrong type ({}).",
+                        column.name(), geometry_type(geom));
+    }
+
+    if (column.needs_isvalid() && !geom::is_valid(geom)) {
+        throw invalid_geometry_exception_t{
+            fmt::format("Invalid geometry for column '{}'.", column.name()),
+            &column};
+    }
+}
+
+void write_geometry(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                    flex_table_column_t const &column,
+                    geom::geometry_t const &geom,
+                    std::vector<expire_tiles_t> *expire)
+{
+    check_geometry(column, geom);
+
+    auto const type = column.type();
+    bool const wrap_multi = (type == table_column_type::multipoint ||
+                             type == table_column_type::multilinestring ||
+                             type == table_column_type::multipolygon);
+    column.do_expire(geom, expire);
+    write_geom_value(copy_mgr, geom_to_ewkb(geom, wrap_multi));
+}
+
 } // anonymous namespace
 
+void flex_write_integer(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                        flex_table_column_t const &column, int64_t value)
+{
+    if (!copy_mgr->binary()) {
+        copy_mgr->add_column(value);
+        return;
+    }
+
+    switch (column.type()) {
+    case table_column_type::int2:
+    case table_column_type::direction:
+    case table_column_type::partition:
+        copy_mgr->add_binary_column(static_cast<int16_t>(value));
+        break;
+    case table_column_type::int4:
+        copy_mgr->add_binary_column(static_cast<int32_t>(value));
+        break;
+    default:
+        copy_mgr->add_binary_column(value);
+        break;
+    }
+}
+
+int64_t flex_row_hash(std::string_view row) noexcept
+{
+    // 64 bit FNV-1a hash
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char const c : row) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return static_cast<int64_t>(hash);
+}
+
+void flex_write_text(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                     char const *str)
+{
+    if (copy_mgr->binary()) {
+        copy_mgr->add_binary_column(std::string_view{str});
+    } else {
+        copy_mgr->add_column(str);
+    }
+}
+
+quadkey_t flex_sort_key(lua_State *lua_state,
+                        flex_table_column_t const &column)
+{
+    quadkey_t key;
+
+    lua_getfield(lua_state, -1, column.name().c_str());
+    if (lua_type(lua_state, -1) == LUA_TUSERDATA) {
+        auto const *const geometry = unpack_geometry(lua_state, -1);
+        if (geometry && !geometry->is_null()) {
+            auto const &proj = get_projection(geometry->srid());
+            auto const center =
+                proj.target_to_tile(geom::envelope(*geometry).center());
+            key = tile_t::from_point(center, flex_table_t::GEOM_KEY_ZOOM)
+                      .quadkey();
+        }
+    }
+    lua_pop(lua_state, 1);
+
+    return key;
+}
+
 void flex_write_column(lua_State *lua_state,
                        db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
                        flex_table_column_t const &column,
@@ -282,14 +447,14 @@ void flex_write_column(lua_State *lua_state,
             throw fmt_error("Invalid type '{}' for text column.",
                             lua_typename(lua_state, ltype));
         }
-        copy_mgr->add_column(str);
+        flex_write_text(copy_mgr, str);
     } else if (column.type() == table_column_type::boolean) {
         switch (ltype) {
         case LUA_TBOOLEAN:
-            copy_mgr->add_column(lua_toboolean(lua_state, -1) != 0);
+            write_bool_value(copy_mgr, lua_toboolean(lua_state, -1) != 0);
             break;
         case LUA_TNUMBER:
-            copy_mgr->add_column(lua_tonumber(lua_state, -1) != 0);
+            write_bool_value(copy_mgr, lua_tonumber(lua_state, -1) != 0);
             break;
         case LUA_TSTRING:
             write_boolean(copy_mgr, column,
@@ -304,7 +469,7 @@ void flex_write_column(lua_State *lua_state,
             int64_t const value = lua_tointeger(lua_state, -1);
             if (value >= std::numeric_limits<int16_t>::min() &&
                 value <= std::numeric_limits<int16_t>::max()) {
-                copy_mgr->add_column(value);
+                flex_write_integer(copy_mgr, column, value);
             } else {
                 write_null(copy_mgr, column);
             }
@@ -312,7 +477,8 @@ void flex_write_column(lua_State *lua_state,
             write_integer<int16_t>(copy_mgr, column,
                                    lua_tolstring(lua_state, -1, nullptr));
         } else if (ltype == LUA_TBOOLEAN) {
-            copy_mgr->add_column(lua_toboolean(lua_state, -1));
+            flex_write_integer(copy_mgr, column,
+                               lua_toboolean(lua_state, -1));
         } else {
             throw fmt_error("Invalid type '{}' for int2 column.",
                             lua_typename(lua_state, ltype));
@@ -322,7 +488,7 @@ void flex_write_column(lua_State *lua_state,
             int64_t const value = lua_tointeger(lua_state, -1);
             if (value >= std::numeric_limits<int32_t>::min() &&
                 value <= std::numeric_limits<int32_t>::max()) {
-                copy_mgr->add_column(value);
+                flex_write_integer(copy_mgr, column, value);
             } else {
                 write_null(copy_mgr, column);
             }
@@ -330,26 +496,28 @@ void flex_write_column(lua_State *lua_state,
             write_integer<int32_t>(copy_mgr, column,
                                    lua_tolstring(lua_state, -1, nullptr));
         } else if (ltype == LUA_TBOOLEAN) {
-            copy_mgr->add_column(lua_toboolean(lua_state, -1));
+            flex_write_integer(copy_mgr, column,
+                               lua_toboolean(lua_state, -1));
         } else {
             throw fmt_error("Invalid type '{}' for int4 column.",
                             lua_typename(lua_state, ltype));
         }
     } else if (column.type() == table_column_type::int8) {
         if (ltype == LUA_TNUMBER) {
-            copy_mgr->add_column(lua_tointeger(lua_state, -1));
+            flex_write_integer(copy_mgr, column, lua_tointeger(lua_state, -1));
         } else if (ltype == LUA_TSTRING) {
             write_integer<int64_t>(copy_mgr, column,
                                    lua_tolstring(lua_state, -1, nullptr));
         } else if (ltype == LUA_TBOOLEAN) {
-            copy_mgr->add_column(lua_toboolean(lua_state, -1));
+            flex_write_integer(copy_mgr, column,
+                               lua_toboolean(lua_state, -1));
         } else {
             throw fmt_error("Invalid type '{}' for int8 column.",
                             lua_typename(lua_state, ltype));
         }
     } else if (column.type() == table_column_type::real) {
         if (ltype == LUA_TNUMBER) {
-            copy_mgr->add_column(lua_tonumber(lua_state, -1));
+            write_real_value(copy_mgr, lua_tonumber(lua_state, -1));
         } else if (ltype == LUA_TSTRING) {
             write_double(copy_mgr, column,
                          lua_tolstring(lua_state, -1, nullptr));
@@ -359,8 +527,14 @@ void flex_write_column(lua_State *lua_state,
         }
     } else if (column.type() == table_column_type::hstore) {
         if (ltype == LUA_TTABLE) {
-            copy_mgr->new_hash();
+            bool const binary = copy_mgr->binary();
+            if (binary) {
+                copy_mgr->new_binary_hash();
+            } else {
+                copy_mgr->new_hash();
+            }
 
+            std::vector<std::pair<std::string, std::string>> sorted;
             luaX_for_each(lua_state, [&]() {
                 char const *const key = lua_tostring(lua_state, -2);
                 char const *const val = lua_tostring(lua_state, -1);
@@ -378,10 +552,29 @@ void flex_write_column(lua_State *lua_state,
                         " an incorrect data type '{}' for key '{}'.",
                         lua_typename(lua_state, ltype_value), key);
                 }
-                copy_mgr->add_hash_elem(key, val);
+                if (column.sort_keys()) {
+                    sorted.emplace_back(key, val);
+                } else if (binary) {
+                    copy_mgr->add_binary_hash_elem(key, val);
+                } else {
+                    copy_mgr->add_hash_elem(key, val);
+                }
             });
 
-            copy_mgr->finish_hash();
+            std::sort(sorted.begin(), sorted.end());
+            for (auto const &[key, val] : sorted) {
+                if (binary) {
+                    copy_mgr->add_binary_hash_elem(key, val);
+                } else {
+                    copy_mgr->add_hash_elem(key, val);
+                }
+            }
+
+            if (binary) {
+                copy_mgr->finish_binary_hash();
+            } else {
+                copy_mgr->finish_hash();
+            }
         } else {
             throw fmt_error("Invalid type '{}' for hstore column.",
                             lua_typename(lua_state, ltype));
@@ -391,14 +584,22 @@ void flex_write_column(lua_State *lua_state,
         json_writer_t writer;
         table_register_type tables;
         write_json(&writer, lua_state, &tables);
-        copy_mgr->add_column(writer.json());
+        if (!copy_mgr->binary()) {
+            copy_mgr->add_column(writer.json());
+        } else if (column.type() == table_column_type::jsonb) {
+            copy_mgr->add_binary_jsonb_column(writer.json());
+        } else {
+            copy_mgr->add_binary_column(writer.json());
+        }
     } else if (column.type() == table_column_type::direction) {
         switch (ltype) {
         case LUA_TBOOLEAN:
-            copy_mgr->add_column(lua_toboolean(lua_state, -1));
+            flex_write_integer(copy_mgr, column,
+                               lua_toboolean(lua_state, -1));
             break;
         case LUA_TNUMBER:
-            copy_mgr->add_column(sgn(lua_tonumber(lua_state, -1)));
+            flex_write_integer(copy_mgr, column,
+                               sgn(lua_tonumber(lua_state, -1)));
             break;
         case LUA_TSTRING:
             write_direction(copy_mgr, column,
@@ -412,24 +613,12 @@ void flex_write_column(lua_State *lua_state,
         if (ltype == LUA_TUSERDATA) {
             auto const *const geom = unpack_geometry(lua_state, -1);
             if (geom && !geom->is_null()) {
-                auto const type = column.type();
-                if (!is_compatible(*geom, type)) {
-                    throw fmt_error("Geometry data for geometry column '{}'"
-                                    " has the wrong type ({}).",
-                                    column.name(), geometry_type(*geom));
-                }
-                bool const wrap_multi =
-                    (type == table_column_type::multipoint ||
-                     type == table_column_type::multilinestring ||
-                     type == table_column_type::multipolygon);
                 if (geom->srid() == column.srid()) {
-                    column.do_expire(*geom, expire);
-                    copy_mgr->add_hex_geom(geom_to_ewkb(*geom, wrap_multi));
+                    write_geometry(copy_mgr, column, *geom, expire);
                 } else {
-                    auto const &proj = get_projection(column.srid());
-                    auto const tgeom = geom::transform(*geom, proj);
-                    column.do_expire(tgeom, expire);
-                    copy_mgr->add_hex_geom(geom_to_ewkb(tgeom, wrap_multi));
+                    write_geometry(copy_mgr, column,
+                                   transform_reusing(*geom, column.srid()),
+                                   expire);
                 }
             } else {
                 write_null(copy_mgr, column);
@@ -445,3 +634,108 @@ void flex_write_column(lua_State *lua_state,
 
     lua_pop(lua_state, 1);
 }
+
+void flex_expire_column(lua_State *lua_state,
+                        flex_table_column_t const &column,
+                        std::vector<expire_tiles_t> *expire)
+{
+    if (column.type() == table_column_type::id_type ||
+        column.type() == table_column_type::id_num) {
+        return;
+    }
+
+    lua_getfield(lua_state, -1, column.name().c_str());
+    int const ltype = lua_type(lua_state, -1);
+
+    if (ltype == LUA_TNIL) {
+        check_not_null(column);
+    } else if (column.is_geometry_column()) {
+        if (ltype != LUA_TUSERDATA) {
+            throw fmt_error("Need geometry data for geometry column '{}'.",
+                            column.name());
+        }
+        auto const *const geom = unpack_geometry(lua_state, -1);
+        if (geom && !geom->is_null()) {
+            auto const &tgeom = geom->srid() == column.srid()
+                                    ? *geom
+                                    : transform_reusing(*geom, column.srid());
+            check_geometry(column, tgeom);
+            column.do_expire(tgeom, expire);
+        } else {
+            check_not_null(column);
+        }
+    }
+
+    lua_pop(lua_state, 1);
+}
+
+void flex_write_derived_column(
+    lua_State *lua_state, db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+    flex_table_column_t const &column, flex_table_column_t const &source,
+    std::vector<expire_tiles_t> *expire)
+{
+    assert(column.is_derived());
+
+    lua_getfield(lua_state, -1, column.name().c_str());
+    if (!lua_isnil(lua_state, -1)) {
+        throw fmt_error("Column '{}' is derived and can not be set.",
+                        column.name());
+    }
+    lua_pop(lua_state, 1);
+
+    lua_getfield(lua_state, -1, source.name().c_str());
+
+    // If there is no geometry in the source column, the derived column is
+    // NULL. Wrong data in the source column is reported when that column
+    // is written.
+    geom::geometry_t const *geom = nullptr;
+    if (lua_type(lua_state, -1) == LUA_TUSERDATA) {
+        geom = unpack_geometry(lua_state, -1);
+    }
+    if (!geom || geom->is_null()) {
+        write_null(copy_mgr, column);
+        lua_pop(lua_state, 1);
+        return;
+    }
+
+    // Geometries are calculated in the projection of the derived column,
+    // areas and lengths in the projection of the source column.
+    int const srid =
+        column.is_geometry_column() ? column.srid() : source.srid();
+
+    if (geom->srid() != srid) {
+        geom = &transform_reusing(*geom, srid);
+    }
+
+    switch (column.derived_func()) {
+    case derived_column_func::centroid: {
+        auto const result = geom::centroid(*geom);
+        if (result.is_null()) {
+            write_null(copy_mgr, column);
+        } else {
+            write_geometry(copy_mgr, column, result, expire);
+        }
+        break;
+    }
+    case derived_column_func::simplify: {
+        auto const result = geom::simplify(*geom, column.tolerance());
+        if (result.is_null()) {
+            write_null(copy_mgr, column);
+        } else {
+            write_geometry(copy_mgr, column, result, expire);
+        }
+        break;
+    }
+    case derived_column_func::area:
+        write_real_value(copy_mgr, geom::area(*geom));
+        break;
+    case derived_column_func::length:
+        write_real_value(copy_mgr, geom::length(*geom));
+        break;
+    case derived_column_func::none:
+        assert(false);
+        break;
+    }
+
+    lua_pop(lua_state, 1);
+}
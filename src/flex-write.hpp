@@ -11,11 +11,14 @@
  */
 
 #include "flex-table.hpp"
+#include "tile.hpp"
 
 #include <lua.hpp>
 
+#include <cstdint>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class expire_tiles_t;
@@ -34,9 +37,72 @@ private:
     flex_table_column_t const *m_column;
 }; // class not_null_exception_t
 
+class invalid_geometry_exception_t : public std::runtime_error
+{
+public:
+    invalid_geometry_exception_t(std::string const &message,
+                                 flex_table_column_t const *column)
+    : std::runtime_error(message), m_column(column)
+    {}
+
+    flex_table_column_t const &column() const noexcept { return *m_column; }
+
+private:
+    flex_table_column_t const *m_column;
+}; // class invalid_geometry_exception_t
+
+/**
+ * Calculate the key for sorting or partitioning the row on top of the Lua
+ * stack by the geometry in the specified column. The key is the quadkey of
+ * the tile on zoom level flex_table_t::GEOM_KEY_ZOOM the center of the
+ * bounding box of the geometry is in. Rows without geometry get the largest
+ * possible key.
+ */
+quadkey_t flex_sort_key(lua_State *lua_state,
+                        flex_table_column_t const &column);
+
+/**
+ * Write an integer value into the specified column. The value must fit into
+ * the column type.
+ */
+void flex_write_integer(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                        flex_table_column_t const &column, int64_t value);
+
+/**
+ * Calculate the hash of the row data used for change detection. This must
+ * give the same result for the same data in every run, so it can't use
+ * std::hash.
+ */
+int64_t flex_row_hash(std::string_view row) noexcept;
+
+/// Write a string value into a text-like column.
+void flex_write_text(db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+                     char const *str);
+
 void flex_write_column(lua_State *lua_state,
                        db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
                        flex_table_column_t const &column,
                        std::vector<expire_tiles_t> *expire);
 
+/**
+ * Check the value in the specified column of the row on top of the Lua
+ * stack and expire the tiles for it if it is a geometry column, but don't
+ * write anything. Used for ephemeral tables. NULL values in NOT NULL
+ * columns, geometries of the wrong type, and invalid geometries are
+ * rejected with the same exceptions flex_write_column() throws, so a row
+ * that would not end up in a normal table doesn't expire any tiles.
+ */
+void flex_expire_column(lua_State *lua_state,
+                        flex_table_column_t const &column,
+                        std::vector<expire_tiles_t> *expire);
+
+/**
+ * Calculate the contents of a derived column from the geometry in its
+ * source column in the row on top of the Lua stack and write it.
+ */
+void flex_write_derived_column(
+    lua_State *lua_state, db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr,
+    flex_table_column_t const &column, flex_table_column_t const &source,
+    std::vector<expire_tiles_t> *expire);
+
 #endif // OSM2PGSQL_FLEX_WRITE_HPP
@@ -18,6 +18,7 @@
 #include <iterator>
 #include <numeric>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace geom {
@@ -124,12 +125,22 @@ geometry_t geometry_n(geometry_t const &input, std::size_t n)
 
 namespace {
 
-void set_to_same_type(geometry_t *output, geometry_t const &input)
+/**
+ * Make sure the output geometry has the same type as the input geometry,
+ * keeping the output geometry (and its memory) if it already has.
+ */
+void reuse_same_type(geometry_t *output, geometry_t const &input)
 {
-    // NOLINTNEXTLINE(performance-unnecessary-value-param)
-    input.visit([&](auto in) { output->set<decltype(in)>(); });
+    input.visit([&](auto const &in) {
+        output->reuse<std::decay_t<decltype(in)>>();
+    });
 }
 
+/**
+ * Transforms the input geometry into the output geometry which must already
+ * have the same type. Existing contents of the output geometry are
+ * overwritten in place so that the memory allocated for them is reused.
+ */
 class transform_visitor_t
 {
 public:
@@ -158,37 +169,38 @@ public:
     void operator()(multipoint_t const &input) const
     {
         auto &mgeom = m_output->get<multipoint_t>();
-        mgeom.reserve(input.num_geometries());
-        for (auto const point : input) {
-            mgeom.add_geometry(project(point));
+        mgeom.resize(input.num_geometries());
+        for (std::size_t i = 0; i < input.num_geometries(); ++i) {
+            mgeom[i] = project(input[i]);
         }
     }
 
     void operator()(multilinestring_t const &input) const
     {
-        auto &mgeom = m_output->set<multilinestring_t>();
-        mgeom.reserve(input.num_geometries());
-        for (auto const &line : input) {
-            transform_points(&mgeom.add_geometry(), line);
+        auto &mgeom = m_output->get<multilinestring_t>();
+        mgeom.resize(input.num_geometries());
+        for (std::size_t i = 0; i < input.num_geometries(); ++i) {
+            transform_points(&mgeom[i], input[i]);
         }
     }
 
     void operator()(multipolygon_t const &input) const
     {
-        auto &mgeom = m_output->set<multipolygon_t>();
-        mgeom.reserve(input.num_geometries());
-        for (auto const &polygon : input) {
-            transform_polygon(&mgeom.add_geometry(), polygon);
+        auto &mgeom = m_output->get<multipolygon_t>();
+        mgeom.resize(input.num_geometries());
+        for (std::size_t i = 0; i < input.num_geometries(); ++i) {
+            transform_polygon(&mgeom[i], input[i]);
         }
     }
 
     void operator()(collection_t const &input) const
     {
         auto &mgeom = m_output->get<collection_t>();
-        mgeom.reserve(input.num_geometries());
-        for (auto const &geom : input) {
-            auto &new_geom = mgeom.add_geometry();
-            set_to_same_type(&new_geom, geom);
+        mgeom.resize(input.num_geometries());
+        for (std::size_t i = 0; i < input.num_geometries(); ++i) {
+            auto const &geom = input[i];
+            auto &new_geom = mgeom[i];
+            reuse_same_type(&new_geom, geom);
             new_geom.set_srid(0);
             geom.visit(transform_visitor_t{&new_geom, m_reprojection});
         }
@@ -202,20 +214,17 @@ private:
 
     void transform_points(point_list_t *output, point_list_t const &input) const
     {
-        output->reserve(input.size());
-        for (auto const &point : input) {
-            output->push_back(project(point));
-        }
+        output->assign(input.cbegin(), input.cend());
+        m_reprojection->reproject_points(output->data(), output->size());
     }
 
     void transform_polygon(polygon_t *output, polygon_t const &input) const
     {
         transform_points(&output->outer(), input.outer());
 
-        output->inners().reserve(input.inners().size());
-        for (auto const &inner : input.inners()) {
-            auto &oring = output->inners().emplace_back();
-            transform_points(&oring, inner);
+        output->inners().resize(input.inners().size());
+        for (std::size_t i = 0; i < input.inners().size(); ++i) {
+            transform_points(&output->inners()[i], input.inners()[i]);
         }
     }
 
@@ -231,7 +240,7 @@ void transform(geometry_t *output, geometry_t const &input,
 {
     assert(input.srid() == PROJ_LATLONG);
 
-    set_to_same_type(output, input);
+    reuse_same_type(output, input);
     output->set_srid(reprojection.target_srs());
     input.visit(transform_visitor_t{output, &reprojection});
 }
@@ -409,6 +418,44 @@ double spherical_area(geometry_t const &geom)
 
 /****************************************************************************/
 
+namespace {
+
+template <typename T>
+bool is_valid_boost(T const &geom)
+{
+    boost::geometry::validity_failure_type failure{};
+    if (boost::geometry::is_valid(geom, failure)) {
+        return true;
+    }
+
+    if (failure != boost::geometry::failure_wrong_orientation) {
+        return false;
+    }
+
+    // PostGIS doesn't care about the orientation of rings, so check again
+    // with the orientation corrected.
+    T corrected{geom};
+    boost::geometry::correct(corrected);
+    return boost::geometry::is_valid(corrected);
+}
+
+} // anonymous namespace
+
+bool is_valid(geometry_t const &geom)
+{
+    return geom.visit(overloaded{
+        [&](geom::nullgeom_t const & /*input*/) { return true; },
+        [&](geom::point_t const & /*input*/) { return true; },
+        [&](geom::multipoint_t const & /*input*/) { return true; },
+        [&](geom::collection_t const &input) {
+            return std::all_of(input.cbegin(), input.cend(),
+                               [](auto const &geom) { return is_valid(geom); });
+        },
+        [&](auto const &input) { return is_valid_boost(input); }});
+}
+
+/****************************************************************************/
+
 double length(geometry_t const &geom)
 {
     return geom.visit(overloaded{
@@ -93,6 +93,10 @@ geometry_t geometry_n(geometry_t const &input, std::size_t n);
 /**
  * Transform a geometry in 4326 into some other projection.
  *
+ * If the output geometry already has the same type as the input geometry,
+ * the memory it has allocated is reused. So using the same output geometry
+ * for many transformations avoids most memory allocations.
+ *
  * \param output Pointer to output geometry.
  * \param input Input geometry.
  * \param reprojection Target projection.
@@ -161,6 +165,16 @@ double area(geometry_t const &geom);
  */
 double spherical_area(geometry_t const &geom);
 
+/**
+ * Check whether the geometry is valid using rules similar to the PostGIS
+ * function ST_IsValid(). The orientation of rings and duplicate points are
+ * not checked. Points and null geometries are always valid.
+ *
+ * \param geom Input geometry.
+ * \returns true if the geometry is valid, false otherwise.
+ */
+bool is_valid(geometry_t const &geom);
+
 /**
  * Split multigeometries into their parts. Non-multi geometries are left
  * alone and will end up as the only geometry in the result vector. If the
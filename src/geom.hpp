@@ -253,6 +253,8 @@ public:
 
     void reserve(std::size_t size) { m_geometry.reserve(size); }
 
+    void resize(std::size_t size) { m_geometry.resize(size); }
+
 private:
     std::vector<GEOM> m_geometry;
 
@@ -369,6 +371,20 @@ public:
         return m_geom.emplace<T>();
     }
 
+    /**
+     * Like set(), but if the geometry already is of type T, it is returned
+     * as is, so the memory it has allocated can be reused. The caller has
+     * to overwrite all of its contents.
+     */
+    template <typename T>
+    constexpr T &reuse()
+    {
+        if (auto *geom = std::get_if<T>(&m_geom)) {
+            return *geom;
+        }
+        return m_geom.emplace<T>();
+    }
+
     template <typename V>
     constexpr auto visit(V &&visitor) const
     {
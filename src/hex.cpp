@@ -11,27 +11,89 @@
 
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include <stdexcept>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OSM2PGSQL_HEX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace util {
 
+namespace {
+
+constexpr char const *const LOOKUP_HEX = "0123456789ABCDEF";
+
+void encode_hex_scalar(unsigned char const *in, std::size_t size, char *out)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        unsigned int const num = in[i];
+        *out++ = LOOKUP_HEX[(num >> 4U) & 0xfU];
+        *out++ = LOOKUP_HEX[num & 0xfU];
+    }
+}
+
+#ifdef OSM2PGSQL_HEX_USE_SSE2
+
+/// Convert 16 values in the range 0-15 into hex characters 0-9A-F.
+__m128i nibbles_to_hex(__m128i nibbles) noexcept
+{
+    __m128i const ascii = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+    __m128i const is_letter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    return _mm_add_epi8(ascii,
+                        _mm_and_si128(is_letter, _mm_set1_epi8('A' - '9' - 1)));
+}
+
+/**
+ * Convert hex encoded data 16 input bytes at a time, the rest is handled
+ * by the scalar code.
+ */
+void encode_hex_impl(unsigned char const *in, std::size_t size, char *out)
+{
+    __m128i const mask = _mm_set1_epi8(0x0f);
+
+    for (; size >= 16; size -= 16, in += 16, out += 32) {
+        __m128i const data =
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(in));
+        __m128i const high =
+            nibbles_to_hex(_mm_and_si128(_mm_srli_epi16(data, 4), mask));
+        __m128i const low = nibbles_to_hex(_mm_and_si128(data, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16),
+                         _mm_unpackhi_epi8(high, low));
+    }
+
+    encode_hex_scalar(in, size, out);
+}
+
+#else
+
+void encode_hex_impl(unsigned char const *in, std::size_t size, char *out)
+{
+    encode_hex_scalar(in, size, out);
+}
+
+#endif
+
+} // anonymous namespace
+
 void encode_hex(std::string const &input, std::string *output)
 {
     assert(output);
 
-    constexpr char const *const LOOKUP_HEX = "0123456789ABCDEF";
+    auto const offset = output->size();
+    output->resize(offset + input.size() * 2);
 
-    for (auto const c : input) {
-        unsigned int const num = static_cast<unsigned char>(c);
-        (*output) += LOOKUP_HEX[(num >> 4U) & 0xfU];
-        (*output) += LOOKUP_HEX[num & 0xfU];
-    }
+    encode_hex_impl(reinterpret_cast<unsigned char const *>(input.data()),
+                    input.size(), &(*output)[offset]);
 }
 
 std::string encode_hex(std::string const &input)
 {
     std::string result;
-    result.reserve(input.size() * 2);
     encode_hex(input, &result);
     return result;
 }
@@ -49,6 +111,73 @@ constexpr std::array<char, 256> HEX_TABLE = {
     0, 10, 11, 12,   13, 14, 15, 0,   0, 0, 0, 0,   0, 0, 0, 0,
 };
 
+void decode_hex_scalar(char const *hex, std::size_t size, char *out) noexcept
+{
+    for (std::size_t i = 0; i < size; i += 2) {
+        unsigned int const c = decode_hex_char(hex[i]);
+        *out++ = static_cast<char>((c << 4U) | decode_hex_char(hex[i + 1]));
+    }
+}
+
+#ifdef OSM2PGSQL_HEX_USE_SSE2
+
+/**
+ * Decode 16 hex characters into their values. Invalid characters are
+ * decoded as 0 like in decode_hex_char().
+ */
+__m128i hex_to_nibbles(__m128i hex) noexcept
+{
+    // Unsigned comparisons "x <= max" are done as "min(x, max) == x".
+    __m128i const digit = _mm_sub_epi8(hex, _mm_set1_epi8('0'));
+    __m128i const is_digit =
+        _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+
+    // Setting bit 0x20 maps upper case letters to lower case letters.
+    __m128i const letter = _mm_sub_epi8(
+        _mm_or_si128(hex, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i const is_letter =
+        _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    return _mm_or_si128(
+        _mm_and_si128(is_digit, digit),
+        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+/// Combine pairs of nibbles into 8 byte values (in 16 bit lanes).
+__m128i combine_nibbles(__m128i nibbles) noexcept
+{
+    __m128i const high = _mm_and_si128(nibbles, _mm_set1_epi16(0x00ff));
+    __m128i const low = _mm_srli_epi16(nibbles, 8);
+    return _mm_or_si128(_mm_slli_epi16(high, 4), low);
+}
+
+/**
+ * Decode hex characters 32 at a time, the rest is handled by the scalar
+ * code.
+ */
+void decode_hex_impl(char const *hex, std::size_t size, char *out) noexcept
+{
+    for (; size >= 32; size -= 32, hex += 32, out += 16) {
+        __m128i const first = combine_nibbles(hex_to_nibbles(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(hex))));
+        __m128i const second = combine_nibbles(hex_to_nibbles(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(hex + 16))));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm_packus_epi16(first, second));
+    }
+
+    decode_hex_scalar(hex, size, out);
+}
+
+#else
+
+void decode_hex_impl(char const *hex, std::size_t size, char *out) noexcept
+{
+    decode_hex_scalar(hex, size, out);
+}
+
+#endif
+
 } // anonymous namespace
 
 unsigned char decode_hex_char(char c) noexcept
@@ -64,13 +193,9 @@ std::string decode_hex(std::string_view hex_string)
     }
 
     std::string wkb;
-    wkb.reserve(hex_string.size() / 2);
+    wkb.resize(hex_string.size() / 2);
 
-    // NOLINTNEXTLINE(llvm-qualified-auto, readability-qualified-auto)
-    for (auto hex = hex_string.cbegin(); hex != hex_string.cend();) {
-        unsigned int const c = decode_hex_char(*hex++);
-        wkb += static_cast<char>((c << 4U) | decode_hex_char(*hex++));
-    }
+    decode_hex_impl(hex_string.data(), hex_string.size(), wkb.data());
 
     return wkb;
 }
@@ -187,6 +187,64 @@ if osm2pgsql.OSMObject then
     end
 end
 
+-- Access to OSM objects through the LuaJIT FFI, only available if osm2pgsql
+-- is built with LuaJIT. The functions need osm2pgsql.ffi_objects = true and
+-- work only while the callback the object was passed to is running. Together
+-- with osm2pgsql.lazy_objects = true this avoids creating the tags table.
+if osm2pgsql._ffi_functions then
+    local ffi = require('ffi')
+
+    ffi.cdef[[
+        typedef struct {
+            const char *key;
+            const char *value;
+        } osm2pgsql_tag_t;
+    ]]
+
+    local funcs = osm2pgsql._ffi_functions
+    osm2pgsql._ffi_functions = nil
+
+    local get_tag = ffi.cast('const char *(*)(const void *, const char *)',
+                             funcs.get_tag)
+    local get_tags = ffi.cast('int (*)(const void *, osm2pgsql_tag_t *, int)',
+                              funcs.get_tags)
+
+    -- Return the pointer to the osmium object or raise an error in the
+    -- function calling the osm2pgsql.ffi function if there is none.
+    local function ffi_pointer(object)
+        local ptr = object._ffi
+        if ptr == nil then
+            error("OSM object not available through the FFI. Set"
+                  .. " osm2pgsql.ffi_objects = true and only use the object"
+                  .. " in the callback it was passed to.", 3)
+        end
+        return ptr
+    end
+
+    osm2pgsql.ffi = {}
+
+    -- Return the value of the tag with the specified key or nil.
+    function osm2pgsql.ffi.get_tag(object, key)
+        local value = get_tag(ffi_pointer(object), key)
+        if value == nil then
+            return nil
+        end
+        return ffi.string(value)
+    end
+
+    -- Return true if the object has a tag with the specified key.
+    function osm2pgsql.ffi.has_tag(object, key)
+        return get_tag(ffi_pointer(object), key) ~= nil
+    end
+
+    -- Fill the array 'tags' created with ffi.new('osm2pgsql_tag_t[?]', size)
+    -- with (at most 'size') tags of the object and return the number of tags.
+    -- Keys and values are C strings.
+    function osm2pgsql.ffi.get_tags(object, tags, size)
+        return get_tags(ffi_pointer(object), tags, size)
+    end
+end
+
 -- This is used to iterate over (multi)geometries.
 function osm2pgsql.Geometry.geometries(geom)
     local i = 0
@@ -0,0 +1,58 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "lua-string-cache.hpp"
+
+#include <cstring>
+
+std::size_t lua_string_cache_t::slot_index(char const *str,
+                                           std::size_t len) noexcept
+{
+    auto const *const s = reinterpret_cast<unsigned char const *>(str);
+    return (len * 131U + s[0] * 31U + s[len / 2] * 7U + s[len - 1]) %
+           NUM_SLOTS;
+}
+
+void lua_string_cache_t::push(lua_State *lua_state, char const *str)
+{
+    auto const len = std::strlen(str);
+    if (len == 0 || len > MAX_LENGTH) {
+        lua_pushlstring(lua_state, str, len);
+        return;
+    }
+
+    auto &slot = m_slots[slot_index(str, len)];
+    if (slot.ref != LUA_NOREF && slot.str.size() == len &&
+        std::memcmp(slot.str.data(), str, len) == 0) {
+        ++m_hits;
+        if (slot.score < MAX_SCORE) {
+            ++slot.score;
+        }
+        lua_rawgeti(lua_state, LUA_REGISTRYINDEX, slot.ref);
+        return;
+    }
+
+    ++m_misses;
+    lua_pushlstring(lua_state, str, len);
+
+    if (slot.score > 0) {
+        --slot.score;
+        return;
+    }
+
+    // Put this string into the slot, replacing what was there before.
+    slot.str.assign(str, len);
+    slot.score = 1;
+    lua_pushvalue(lua_state, -1);
+    if (slot.ref == LUA_NOREF) {
+        slot.ref = luaL_ref(lua_state, LUA_REGISTRYINDEX);
+    } else {
+        lua_rawseti(lua_state, LUA_REGISTRYINDEX, slot.ref);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef OSM2PGSQL_LUA_STRING_CACHE_HPP
+#define OSM2PGSQL_LUA_STRING_CACHE_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <lua.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Cache for strings which are pushed onto the Lua stack again and again,
+ * like the keys and common values of OSM tags. Pushing a new string onto
+ * the Lua stack means Lua has to hash it and look it up in its string
+ * table. Strings in the cache are kept in the Lua registry and can be
+ * pushed with a simple array lookup instead.
+ *
+ * The cache has a fixed number of slots. The slot for a string is found
+ * using its length and a few of its characters, which is much cheaper than
+ * a full hash. Each slot has a score that goes up with every hit and down
+ * with every miss, a string is only replaced once its score is down to
+ * zero. This way strings that are used often stay in the cache.
+ *
+ * The cache must only be used with the Lua state it was first used with.
+ */
+class lua_string_cache_t
+{
+public:
+    /// Number of slots in the cache.
+    static constexpr std::size_t NUM_SLOTS = 1024;
+
+    /**
+     * Strings longer than this are not cached. Lua only interns short
+     * strings anyway.
+     */
+    static constexpr std::size_t MAX_LENGTH = 40;
+
+    /// The maximum score a slot can reach.
+    static constexpr uint32_t MAX_SCORE = 16;
+
+    lua_string_cache_t() : m_slots(NUM_SLOTS) {}
+
+    /// Push the (null-terminated) string onto the Lua stack.
+    void push(lua_State *lua_state, char const *str);
+
+    std::size_t hits() const noexcept { return m_hits; }
+
+    std::size_t misses() const noexcept { return m_misses; }
+
+private:
+    struct slot_t
+    {
+        std::string str;
+        int ref = LUA_NOREF;
+        uint32_t score = 0;
+    };
+
+    static std::size_t slot_index(char const *str, std::size_t len) noexcept;
+
+    std::vector<slot_t> m_slots;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+
+}; // class lua_string_cache_t
+
+#endif // OSM2PGSQL_LUA_STRING_CACHE_HPP
@@ -261,6 +261,35 @@ int luaX_pcall(lua_State *lua_state, int narg, int nres)
 
 #endif
 
+namespace {
+
+int dump_writer(lua_State * /*lua_state*/, void const *data, std::size_t size,
+                void *str)
+{
+    static_cast<std::string *>(str)->append(static_cast<char const *>(data),
+                                            size);
+    return 0;
+}
+
+} // anonymous namespace
+
+std::string luaX_dump_function(lua_State *lua_state)
+{
+    assert(lua_isfunction(lua_state, -1));
+
+    std::string chunk;
+#if LUA_VERSION_NUM >= 503
+    int const result = lua_dump(lua_state, dump_writer, &chunk, 0);
+#else
+    int const result = lua_dump(lua_state, dump_writer, &chunk);
+#endif
+    if (result != 0) {
+        throw fmt_error("Dumping Lua function failed (error {}).", result);
+    }
+
+    return chunk;
+}
+
 bool luaX_is_empty_table(lua_State *lua_state)
 {
     assert(lua_istable(lua_state, -1));
@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cstdint>
 #include <initializer_list>
+#include <string>
 #include <string_view>
 #include <utility>
 
@@ -44,10 +45,9 @@ void luaX_set_up_metatable(
     std::initializer_list<std::pair<char const *, lua_CFunction>> map);
 
 template <typename COLLECTION, typename FUNC>
-void luaX_add_table_array(lua_State *lua_state, char const *key,
-                          COLLECTION const &collection, FUNC const &func)
+void luaX_push_array(lua_State *lua_state, COLLECTION const &collection,
+                     FUNC const &func)
 {
-    lua_pushstring(lua_state, key);
     lua_createtable(lua_state, (int)collection.size(), 0);
     int n = 0;
     for (auto const &member : collection) {
@@ -55,6 +55,14 @@ void luaX_add_table_array(lua_State *lua_state, char const *key,
         func(member);
         lua_rawset(lua_state, -3);
     }
+}
+
+template <typename COLLECTION, typename FUNC>
+void luaX_add_table_array(lua_State *lua_state, char const *key,
+                          COLLECTION const &collection, FUNC const &func)
+{
+    lua_pushstring(lua_state, key);
+    luaX_push_array(lua_state, collection, func);
     lua_rawset(lua_state, -3);
 }
 
@@ -75,6 +83,18 @@ bool luaX_get_table_bool(lua_State *lua_state, char const *key, int table_index,
 
 int luaX_pcall(lua_State *lua_state, int narg, int nres);
 
+/**
+ * Dump the Lua function on top of the stack as binary chunk into a string.
+ * The chunk can later be loaded again with luaL_loadbuffer() into the same
+ * or another Lua state, which is faster than compiling the source code.
+ * Debug information is kept, so that error messages still contain file
+ * names and line numbers.
+ *
+ * \pre Value on top of the Lua stack must be a Lua function.
+ * \post Stack is unchanged.
+ */
+std::string luaX_dump_function(lua_State *lua_state);
+
 /**
  * Returns true if the value on top of the stack is an empty Lua table.
  *
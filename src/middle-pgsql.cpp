@@ -110,6 +110,14 @@ void middle_pgsql_t::table_desc_t::drop_table(
              util::human_readable_duration(timer.stop()));
 }
 
+void middle_pgsql_t::table_desc_t::set_logged(
+    pg_conn_t const &db_connection) const
+{
+    log_info("Setting table '{}' to LOGGED...", name());
+    db_connection.exec("ALTER TABLE {} SET LOGGED",
+                       qualified_name(schema(), name()));
+}
+
 void middle_pgsql_t::table_desc_t::init_max_id(pg_conn_t const &db_connection)
 {
     auto const qual_name = qualified_name(schema(), name());
@@ -1124,6 +1132,9 @@ void middle_pgsql_t::build_way_node_index()
     m_tables.ways().task_set(thread_pool().submit([&, create_ways_index]() {
         pg_conn_t const db_connection{m_options->connection_params,
                                       "middle.index.ways"};
+        if (m_options->unlogged) {
+            m_tables.ways().set_logged(db_connection);
+        }
         db_connection.exec(create_ways_index);
     }));
 }
@@ -1155,6 +1166,9 @@ void middle_pgsql_t::build_relation_member_indexes()
         [&, create_rels_index_node_members, create_rels_index_way_members]() {
             pg_conn_t const db_connection{m_options->connection_params,
                                           "middle.index.rels"};
+            if (m_options->unlogged) {
+                m_tables.relations().set_logged(db_connection);
+            }
             db_connection.exec(create_rels_index_node_members);
             db_connection.exec(create_rels_index_way_members);
         }));
@@ -1174,6 +1188,13 @@ void middle_pgsql_t::stop()
             table.drop_table(m_db_connection);
         }
     } else if (!m_options->append) {
+        if (m_options->unlogged && m_store_options.nodes) {
+            m_tables.nodes().task_set(thread_pool().submit([&]() {
+                pg_conn_t const db_connection{m_options->connection_params,
+                                              "middle.logged.nodes"};
+                m_tables.nodes().set_logged(db_connection);
+            }));
+        }
         build_way_node_index();
         build_relation_member_indexes();
     }
@@ -1196,7 +1217,8 @@ void init_params(params_t *params, options_t const &options)
 
     params->set("prefix", options.prefix);
     params->set("schema", schema);
-    params->set("unlogged", options.droptemp ? "UNLOGGED" : "");
+    params->set("unlogged",
+                (options.droptemp || options.unlogged) ? "UNLOGGED" : "");
     params->set("data_tablespace", tablespace_clause(options.tblsslim_data));
     params->set("index_tablespace", tablespace_clause(options.tblsslim_index));
     params->set("way_node_index_id_shift", 5);
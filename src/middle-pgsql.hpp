@@ -134,6 +134,9 @@ struct middle_pgsql_t : public middle_t
         ///< Drop table from database using existing database connection.
         void drop_table(pg_conn_t const &db_connection) const;
 
+        /// Set table created as UNLOGGED to LOGGED.
+        void set_logged(pg_conn_t const &db_connection) const;
+
         void task_set(std::future<std::chrono::microseconds> &&future)
         {
             m_task_result.set(std::move(future));
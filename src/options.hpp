@@ -142,6 +142,20 @@ struct options_t
     bool reproject_area = false;
 
     bool parallel_indexing = true;
+
+    /**
+     * Create all tables as UNLOGGED on import and set them to LOGGED after
+     * they have been filled and clustered.
+     */
+    bool unlogged = false;
+
+    /**
+     * Collect timings of the Lua code in the flex output ("calls") and
+     * optionally also sample the Lua source lines ("lines"). Empty if not
+     * enabled.
+     */
+    std::string lua_profile;
+
     bool pass_prompt = false;
 }; // struct options_t
 
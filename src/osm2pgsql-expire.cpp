@@ -9,18 +9,21 @@
 
 #include "command-line-app.hpp"
 #include "expire-config.hpp"
+#include "expire-from-db.hpp"
 #include "expire-output.hpp"
 #include "expire-tiles.hpp"
 #include "format.hpp"
 #include "geom-from-osm.hpp"
 #include "geom-functions.hpp"
 #include "geom.hpp"
+#include "idlist.hpp"
 #include "input.hpp"
 #include "logging.hpp"
 #include "middle-ram.hpp"
 #include "middle.hpp"
 #include "osmdata.hpp"
 #include "output.hpp"
+#include "pgsql.hpp"
 #include "reprojection.hpp"
 #include "tile.hpp"
 #include "version.hpp"
@@ -29,7 +32,9 @@
 
 #include <cassert>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 namespace {
 
@@ -40,6 +45,7 @@ struct config_t
     std::string mode{"full_area"};
     std::string format{"tiles"};
     std::shared_ptr<reprojection_t> projection;
+    expire_db_config_t db;
     command_t command = command_t::process;
     uint32_t zoom = 0;
 };
@@ -266,12 +272,14 @@ config_t parse_command_line(int argc, char *argv[])
     config_t cfg;
 
     command_line_app_t app{"osm2pgsql-expire -- Visualize expire output\n"};
+    app.init_database_options();
     app.init_logging_options(false, false);
 
     app.get_formatter()->column_width(38);
 
     app.add_option("OSMFILE", cfg.input_file)
-        ->description("Input file")
+        ->description(
+            "Input file (OSM file, tiles file or, with --table, id file)")
         ->type_name("FILE");
 
     app.add_option("-b,--buffer", cfg.expire_config.buffer)
@@ -295,6 +303,32 @@ config_t parse_command_line(int argc, char *argv[])
         ->description("Set zoom level")
         ->type_name("ZOOM");
 
+    app.add_option("-t,--table", cfg.db.table)
+        ->description("Read geometries for ids in OSMFILE from this table")
+        ->type_name("TABLE")
+        ->group("Database options");
+
+    app.add_option("--schema", cfg.db.schema)
+        ->description("Schema of the table (default: 'public')")
+        ->type_name("SCHEMA")
+        ->group("Database options");
+
+    app.add_option("--id-column", cfg.db.id_column)
+        ->description("Id column in the table (default: 'osm_id')")
+        ->type_name("COLUMN")
+        ->group("Database options");
+
+    app.add_option("--geom-column", cfg.db.geom_column)
+        ->description("Geometry column in the table (default: 'geom')")
+        ->type_name("COLUMN")
+        ->group("Database options");
+
+    app.add_option("-j,--jobs", cfg.db.num_threads)
+        ->description("Number of parallel database connections (default: 4)")
+        ->check(CLI::Range(1, 256))
+        ->type_name("NUM")
+        ->group("Database options");
+
     try {
         app.parse(argc, argv);
     } catch (...) {
@@ -318,6 +352,15 @@ config_t parse_command_line(int argc, char *argv[])
             "Value for --format must be 'tiles' or 'geojson'."};
     }
 
+    if (!cfg.db.table.empty()) {
+        check_identifier(cfg.db.schema, "--schema");
+        check_identifier(cfg.db.table, "--table");
+        check_identifier(cfg.db.id_column, "--id-column");
+        check_identifier(cfg.db.geom_column, "--geom-column");
+    }
+
+    cfg.db.connection_params = app.connection_params();
+
     if (cfg.mode == "boundary_only") {
         cfg.expire_config.mode = expire_mode::boundary_only;
     } else if (cfg.mode == "full_area") {
@@ -332,12 +375,12 @@ config_t parse_command_line(int argc, char *argv[])
     return cfg;
 }
 
-void output_expire_t::print(std::string const &format)
+void print_quadkeys(quadkey_list_t const &tiles, uint32_t zoom,
+                    std::string const &format)
 {
-    auto const tiles = m_expire_tiles.get_tiles();
     if (format == "tiles") {
         for (auto const &qk : tiles) {
-            auto const tile = tile_t::from_quadkey(qk, m_config.zoom);
+            auto const tile = tile_t::from_quadkey(qk, zoom);
             fmt::print(stdout, "{}\n", tile.to_zxy());
         }
         return;
@@ -349,12 +392,35 @@ void output_expire_t::print(std::string const &format)
     bool first = true;
     for (auto const &qk : tiles) {
         fmt::print("{}{}\n", (first ? "" : ","),
-                   tile_to_json(tile_t::from_quadkey(qk, m_config.zoom)));
+                   tile_to_json(tile_t::from_quadkey(qk, zoom)));
         first = false;
     }
     fmt::print("{}", geojson_end());
 }
 
+void output_expire_t::print(std::string const &format)
+{
+    print_quadkeys(m_expire_tiles.get_tiles(), m_config.zoom, format);
+}
+
+/**
+ * Read ids from a file (one per line). Returns the ids sorted and without
+ * duplicates.
+ */
+idlist_t read_ids_from_file(std::string const &filename)
+{
+    std::ifstream file{filename};
+    if (!file) {
+        throw fmt_error("Could not open id file '{}'.", filename);
+    }
+
+    try {
+        return read_ids(file);
+    } catch (std::runtime_error const &e) {
+        throw fmt_error("Error in id file '{}': {}", filename, e.what());
+    }
+}
+
 } // anonymous namespace
 
 // NOLINTNEXTLINE(bugprone-exception-escape)
@@ -389,6 +455,12 @@ int main(int argc, char *argv[])
         log_info("  full_area_limit={}", cfg.expire_config.full_area_limit);
         log_info("  mode={}", cfg.mode);
         log_info("  zoom={}", cfg.zoom);
+        if (!cfg.db.table.empty()) {
+            log_info("  table={}", qualified_name(cfg.db.schema, cfg.db.table));
+            log_info("  id_column={}", cfg.db.id_column);
+            log_info("  geom_column={}", cfg.db.geom_column);
+            log_info("  jobs={}", cfg.db.num_threads);
+        }
 
         auto const input = osmium::split_string(cfg.input_file, '.');
         if (input.empty()) {
@@ -396,7 +468,13 @@ int main(int argc, char *argv[])
         }
 
         auto const &suffix = input.back();
-        if (suffix == "osm" || suffix == "pbf" || suffix == "opl") {
+        if (!cfg.db.table.empty()) {
+            // input is a list of ids to look up in the database
+            auto const ids = read_ids_from_file(cfg.input_file);
+            print_quadkeys(
+                expire_from_db(cfg.db, ids, cfg.expire_config, cfg.zoom),
+                cfg.zoom, cfg.format);
+        } else if (suffix == "osm" || suffix == "pbf" || suffix == "opl") {
             // input is an OSM file
             auto thread_pool = std::make_shared<thread_pool_t>(1U);
             log_debug("Started pool with {} threads.",
@@ -36,6 +36,15 @@ osmdata_t::osmdata_t(std::shared_ptr<middle_t> mid,
     assert(m_mid);
     assert(m_output);
     m_output->start();
+
+    if (!m_append && m_num_procs > 1 && m_output->supports_parallel_import()) {
+        m_parallel_import = std::make_unique<parallel_import_t>(
+            m_connection_params, m_mid, m_output, m_num_procs);
+
+        // The ram middle keeps ways and relations in the same buffer, so
+        // ways can not be read from it while relations are added.
+        m_parallel_relations = options.slim;
+    }
 }
 
 void osmdata_t::node(osmium::Node const &node)
@@ -108,6 +117,8 @@ void osmdata_t::way(osmium::Way &way)
         if (way.version() != 1) {
             m_changed_ways.push_back(way.id());
         }
+    } else if (m_parallel_import) {
+        m_parallel_import->add(way);
     } else {
         m_output->way_add(&way);
     }
@@ -115,6 +126,10 @@ void osmdata_t::way(osmium::Way &way)
 
 void osmdata_t::after_ways()
 {
+    if (m_parallel_import) {
+        m_parallel_import->finish();
+    }
+
     m_mid->after_ways();
     m_output->after_ways();
 
@@ -168,6 +183,8 @@ void osmdata_t::relation(osmium::Relation const &rel)
     if (m_append) {
         m_output->relation_modify(rel);
         m_changed_relations.push_back(rel.id());
+    } else if (m_parallel_relations) {
+        m_parallel_import->add(rel);
     } else {
         m_output->relation_add(rel);
     }
@@ -175,6 +192,12 @@ void osmdata_t::relation(osmium::Relation const &rel)
 
 void osmdata_t::after_relations()
 {
+    if (m_parallel_import) {
+        m_parallel_import->finish();
+        m_parallel_import->merge_expire_trees();
+        m_parallel_import.reset();
+    }
+
     m_mid->after_relations();
     m_output->after_relations();
 
@@ -255,11 +278,28 @@ public:
     /**
      * Collect expiry tree information from all clones and merge it back
      * into the original output.
+     *
+     * The clones are merged pairwise in parallel in log2(n) rounds, so
+     * that only a single merge into the original output remains.
      */
     void merge_expire_trees()
     {
-        for (auto const &clone : m_clones) {
-            m_output->merge_expire_trees(clone.get());
+        for (std::size_t step = 1; step < m_clones.size(); step *= 2) {
+            std::vector<std::future<void>> workers;
+            for (std::size_t i = 0; i + step < m_clones.size(); i += 2 * step) {
+                workers.push_back(std::async(
+                    std::launch::async, [this, i, step]() {
+                        m_clones[i]->merge_expire_trees(
+                            m_clones[i + step].get());
+                    }));
+            }
+            for (auto &worker : workers) {
+                worker.get();
+            }
+        }
+
+        if (!m_clones.empty()) {
+            m_output->merge_expire_trees(m_clones[0].get());
         }
     }
 
@@ -25,6 +25,7 @@
 
 #include "idlist.hpp"
 #include "osmtypes.hpp"
+#include "parallel-import.hpp"
 #include "pgsql-params.hpp"
 
 class middle_t;
@@ -108,6 +109,13 @@ private:
     std::shared_ptr<middle_t> m_mid;
     std::shared_ptr<output_t> m_output;
 
+    /**
+     * Used to process ways (and relations if m_parallel_relations is set)
+     * in several threads during import. Not set if the output doesn't
+     * support this or only one thread is used.
+     */
+    std::unique_ptr<parallel_import_t> m_parallel_import;
+
     connection_params_t m_connection_params;
 
     // Bounding box for node import (or invalid Box if everything should be
@@ -117,6 +125,7 @@ private:
     unsigned int m_num_procs;
     bool m_append;
     bool m_droptemp;
+    bool m_parallel_relations = false;
 };
 
 #endif // OSM2PGSQL_OSMDATA_HPP
@@ -15,9 +15,11 @@
 #include "expire-tiles.hpp"
 #include "flex-index.hpp"
 #include "flex-lua-expire-output.hpp"
+#include "flex-lua-ffi.hpp"
 #include "flex-lua-geom.hpp"
 #include "flex-lua-index.hpp"
 #include "flex-lua-locator.hpp"
+#include "flex-lua-profile.hpp"
 #include "flex-lua-table.hpp"
 #include "flex-lua-wrapper.hpp"
 #include "flex-write.hpp"
@@ -27,6 +29,7 @@
 #include "logging.hpp"
 #include "lua-init.hpp"
 #include "lua-setup.hpp"
+#include "lua-string-cache.hpp"
 #include "lua-utils.hpp"
 #include "middle.hpp"
 #include "options.hpp"
@@ -123,8 +126,183 @@ namespace {
 
 char const *const OSM2PGSQL_OSMOBJECT_CLASS = "osm2pgsql.OSMObject";
 
+/**
+ * Name of the table in the Lua registry mapping OSM objects (Lua tables) to
+ * the osmium objects they were created from. This is used for lazy objects
+ * and for the objects in a batch. Entries are only valid while the Lua
+ * callback the object was passed to is running.
+ */
+char const *const OSM2PGSQL_CALLBACK_OBJECTS = "osm2pgsql.callback_objects";
+
+/// Number of objects collected before a batch function is called.
+constexpr std::size_t const BATCH_SIZE = 1000;
+
+/// Maximum memory used for caching relations and members in append mode.
+constexpr std::size_t const RELATION_LRU_CACHE_SIZE = 128UL * 1024UL * 1024UL;
+
+/**
+ * Remember which osmium object the Lua table on top of the stack was
+ * created from.
+ */
+void register_callback_object(lua_State *lua_state,
+                              osmium::OSMObject const &object)
+{
+    lua_getfield(lua_state, LUA_REGISTRYINDEX, OSM2PGSQL_CALLBACK_OBJECTS);
+    lua_pushvalue(lua_state, -2);
+    lua_pushlightuserdata(lua_state, const_cast<osmium::OSMObject *>(&object));
+    lua_rawset(lua_state, -3);
+    lua_pop(lua_state, 1); // callback objects table
+}
+
+/**
+ * Get the osmium object the Lua table at the specified stack index was
+ * created from. Returns nullptr if it isn't a registered object.
+ */
+osmium::OSMObject const *get_callback_object(lua_State *lua_state, int index)
+{
+    assert(index > 0);
+    if (index > lua_gettop(lua_state)) {
+        return nullptr;
+    }
+
+    lua_getfield(lua_state, LUA_REGISTRYINDEX, OSM2PGSQL_CALLBACK_OBJECTS);
+    lua_pushvalue(lua_state, index);
+    lua_rawget(lua_state, -2);
+    auto const *const object =
+        static_cast<osmium::OSMObject const *>(lua_touserdata(lua_state, -1));
+    lua_pop(lua_state, 2);
+
+    return object;
+}
+
+/**
+ * Push the tags of the object as Lua table onto the Lua stack. Keys and
+ * values are pushed through the string cache, because the same strings
+ * come up again and again.
+ */
+void push_tags(lua_State *lua_state, osmium::OSMObject const &object,
+               lua_string_cache_t *string_cache)
+{
+    assert(string_cache);
+
+    lua_createtable(lua_state, 0, (int)object.tags().size());
+    for (auto const &tag : object.tags()) {
+        string_cache->push(lua_state, tag.key());
+        string_cache->push(lua_state, tag.value());
+        lua_rawset(lua_state, -3);
+    }
+}
+
+void push_way_nodes(lua_State *lua_state, osmium::Way const &way)
+{
+    luaX_push_array(lua_state, way.nodes(), [&](osmium::NodeRef const &wn) {
+        lua_pushinteger(lua_state, wn.ref());
+    });
+}
+
+void push_relation_members(lua_State *lua_state,
+                           osmium::Relation const &relation)
+{
+    luaX_push_array(lua_state, relation.members(),
+                    [&](osmium::RelationMember const &member) {
+                        lua_createtable(lua_state, 0, 3);
+                        std::array<char, 2> tmp{"x"};
+                        tmp[0] = osmium::item_type_to_char(member.type());
+                        luaX_add_table_str(lua_state, "type", tmp.data());
+                        luaX_add_table_int(lua_state, "ref", member.ref());
+                        luaX_add_table_str(lua_state, "role", member.role());
+                    });
+}
+
+/**
+ * The __index function of the OSMObject metatable used for lazy objects.
+ * Looks up methods first, then creates the "tags", "nodes", or "members"
+ * field on first access and stores it in the object, so this is only
+ * called once per field. The string cache is in the first upvalue.
+ */
+int lua_lazy_object_index(lua_State *lua_state)
+{
+    luaL_getmetatable(lua_state, OSM2PGSQL_OSMOBJECT_CLASS);
+    lua_pushvalue(lua_state, 2);
+    lua_rawget(lua_state, -2);
+    if (!lua_isnil(lua_state, -1) || lua_type(lua_state, 2) != LUA_TSTRING) {
+        return 1;
+    }
+    lua_settop(lua_state, 2);
+
+    std::string_view const key = lua_tostring(lua_state, 2);
+    if (key != "tags" && key != "nodes" && key != "members") {
+        lua_pushnil(lua_state);
+        return 1;
+    }
+
+    auto const *const object = get_callback_object(lua_state, 1);
+    if (!object) {
+        return luaL_error(lua_state,
+                          "Can not access '%s' of OSM object outside the "
+                          "callback it was passed to.",
+                          key.data());
+    }
+    lua_settop(lua_state, 2);
+
+    if (key == "tags") {
+        push_tags(lua_state, *object,
+                  static_cast<lua_string_cache_t *>(
+                      lua_touserdata(lua_state, lua_upvalueindex(1))));
+    } else if (key == "nodes" && object->type() == osmium::item_type::way) {
+        push_way_nodes(lua_state, static_cast<osmium::Way const &>(*object));
+    } else if (key == "members" &&
+               object->type() == osmium::item_type::relation) {
+        push_relation_members(lua_state,
+                              static_cast<osmium::Relation const &>(*object));
+    } else {
+        lua_pushnil(lua_state);
+        return 1;
+    }
+
+    lua_pushvalue(lua_state, 2);
+    lua_pushvalue(lua_state, -2);
+    lua_rawset(lua_state, 1);
+
+    return 1;
+}
+
+/**
+ * The __pairs function of the OSMObject metatable used for lazy objects.
+ * Creates all lazy fields first (if the object is still valid), so that
+ * pairs() returns them like for normal objects. The "next" function is in
+ * the first upvalue. Lua 5.1 and LuaJIT (without 5.2 compatibility) don't
+ * support __pairs, there pairs() only returns the fields already accessed.
+ */
+int lua_lazy_object_pairs(lua_State *lua_state)
+{
+    luaL_checktype(lua_state, 1, LUA_TTABLE);
+    lua_settop(lua_state, 1);
+
+    if (get_callback_object(lua_state, 1)) {
+        for (char const *const key : {"tags", "nodes", "members"}) {
+            lua_getfield(lua_state, 1, key);
+            lua_pop(lua_state, 1);
+        }
+    }
+
+    lua_pushvalue(lua_state, lua_upvalueindex(1));
+    lua_pushvalue(lua_state, 1);
+    lua_pushnil(lua_state);
+    return 3;
+}
+
+/**
+ * Push the OSM object as Lua table onto the Lua stack. If lazy is set, the
+ * "tags", "nodes", and "members" fields are not filled in, instead the
+ * object is registered so that lua_lazy_object_index() can create them on
+ * demand. If ffi is set, the object is registered and a pointer to it is
+ * stored in the "_ffi" field for use by the functions in flex-lua-ffi.cpp.
+ */
 void push_osm_object_to_lua_stack(lua_State *lua_state,
-                                  osmium::OSMObject const &object)
+                                  osmium::OSMObject const &object,
+                                  lua_string_cache_t *string_cache,
+                                  bool lazy = false, bool ffi = false)
 {
     assert(lua_state);
 
@@ -164,31 +342,36 @@ void push_osm_object_to_lua_stack(lua_State *lua_state,
             auto const &way = static_cast<osmium::Way const &>(object);
             luaX_add_table_bool(lua_state, "is_closed",
                                 !way.nodes().empty() && way.is_closed());
-            luaX_add_table_array(lua_state, "nodes", way.nodes(),
-                                 [&](osmium::NodeRef const &wn) {
-                                     lua_pushinteger(lua_state, wn.ref());
-                                 });
-        } else if (object.type() == osmium::item_type::relation) {
-            auto const &relation =
-                static_cast<osmium::Relation const &>(object);
-            luaX_add_table_array(
-                lua_state, "members", relation.members(),
-                [&](osmium::RelationMember const &member) {
-                    lua_createtable(lua_state, 0, 3);
-                    std::array<char, 2> tmp{"x"};
-                    tmp[0] = osmium::item_type_to_char(member.type());
-                    luaX_add_table_str(lua_state, "type", tmp.data());
-                    luaX_add_table_int(lua_state, "ref", member.ref());
-                    luaX_add_table_str(lua_state, "role", member.role());
-                });
         }
 
-        lua_pushliteral(lua_state, "tags");
-        lua_createtable(lua_state, 0, (int)object.tags().size());
-        for (auto const &tag : object.tags()) {
-            luaX_add_table_str(lua_state, tag.key(), tag.value());
+        if (lazy || ffi) {
+            register_callback_object(lua_state, object);
+        }
+
+        if (ffi) {
+            lua_pushliteral(lua_state, "_ffi");
+            lua_pushlightuserdata(lua_state,
+                                  const_cast<osmium::OSMObject *>(&object));
+            lua_rawset(lua_state, -3);
+        }
+
+        if (!lazy) {
+            if (object.type() == osmium::item_type::way) {
+                lua_pushliteral(lua_state, "nodes");
+                push_way_nodes(lua_state,
+                               static_cast<osmium::Way const &>(object));
+                lua_rawset(lua_state, -3);
+            } else if (object.type() == osmium::item_type::relation) {
+                lua_pushliteral(lua_state, "members");
+                push_relation_members(
+                    lua_state, static_cast<osmium::Relation const &>(object));
+                lua_rawset(lua_state, -3);
+            }
+
+            lua_pushliteral(lua_state, "tags");
+            push_tags(lua_state, object, string_cache);
+            lua_rawset(lua_state, -3);
         }
-        lua_rawset(lua_state, -3);
 
         // Set the metatable of this object
         lua_pushstring(lua_state, OSM2PGSQL_OSMOBJECT_CLASS);
@@ -197,6 +380,27 @@ void push_osm_object_to_lua_stack(lua_State *lua_state,
     }
 }
 
+/**
+ * Remove all objects from the table of callback objects. Called after each
+ * callback, because the osmium objects they point to are not valid any
+ * more afterwards. This also removes the "_ffi" field from the objects.
+ */
+void clear_callback_objects(lua_State *lua_state)
+{
+    lua_getfield(lua_state, LUA_REGISTRYINDEX, OSM2PGSQL_CALLBACK_OBJECTS);
+    lua_pushnil(lua_state);
+    while (lua_next(lua_state, -2) != 0) {
+        lua_pop(lua_state, 1); // value
+        lua_pushliteral(lua_state, "_ffi");
+        lua_pushnil(lua_state);
+        lua_rawset(lua_state, -3);
+        lua_pushvalue(lua_state, -1);
+        lua_pushnil(lua_state);
+        lua_rawset(lua_state, -4);
+    }
+    lua_pop(lua_state, 1); // callback objects table
+}
+
 /**
  * Helper function to push the lon/lat of the specified location onto the
  * Lua stack
@@ -330,6 +534,62 @@ void check_for_object(lua_State *lua_state, char const *const function_name)
              function_name);
 }
 
+/**
+ * Set up the tag filter from the osm2pgsql.tag_filter Lua table on top of
+ * the stack. It can contain the fields "node", "way", and "relation" which
+ * must be arrays of pattern strings.
+ */
+void setup_tag_filter(lua_State *lua_state, flex_tag_filter_t *filter)
+{
+    if (!lua_istable(lua_state, -1)) {
+        throw std::runtime_error{"osm2pgsql.tag_filter must be a table."};
+    }
+
+    lua_pushnil(lua_state);
+    while (lua_next(lua_state, -2) != 0) {
+        lua_pop(lua_state, 1); // value
+        char const *const name = lua_type(lua_state, -1) == LUA_TSTRING
+                                     ? lua_tostring(lua_state, -1)
+                                     : "";
+        if (std::strcmp(name, "node") != 0 && std::strcmp(name, "way") != 0 &&
+            std::strcmp(name, "relation") != 0) {
+            throw std::runtime_error{
+                "osm2pgsql.tag_filter can only contain the fields 'node', "
+                "'way', and 'relation'."};
+        }
+    }
+
+    for (auto const type : {osmium::item_type::node, osmium::item_type::way,
+                            osmium::item_type::relation}) {
+        char const *const name = osmium::item_type_to_name(type);
+        lua_getfield(lua_state, -1, name);
+        if (lua_isnil(lua_state, -1)) {
+            lua_pop(lua_state, 1);
+            continue;
+        }
+
+        if (!lua_istable(lua_state, -1) || !luaX_is_array(lua_state)) {
+            throw fmt_error("osm2pgsql.tag_filter.{} must be an array of "
+                            "strings.",
+                            name);
+        }
+
+        filter->enable(type);
+        luaX_for_each(lua_state, [&]() {
+            if (lua_type(lua_state, -1) != LUA_TSTRING) {
+                throw fmt_error("osm2pgsql.tag_filter.{} must be an array of "
+                                "strings.",
+                                name);
+            }
+            filter->add(type, lua_tostring(lua_state, -1));
+        });
+        lua_pop(lua_state, 1);
+
+        log_debug("Tag filter for {}s has {} pattern(s).", name,
+                  filter->num_patterns(type));
+    }
+}
+
 /**
  * Expects a Lua (hash) table on the stack, reads the field with name of the
  * 'type' parameter which must be either nil or a Lua (array) table, in which
@@ -388,6 +648,7 @@ void output_flex_t::check_context_and_state(char const *name,
                                             char const *context, bool condition)
 {
     check_for_object(lua_state(), name);
+    select_batch_object(1);
 
     if (condition) {
         throw fmt_error(
@@ -455,6 +716,7 @@ int output_flex_t::app_get_bbox()
 int output_flex_t::app_as_point()
 {
     check_for_object(lua_state(), "as_point");
+    select_batch_object(1);
 
     if (m_calling_context == calling_context::process_node) {
         if (lua_gettop(lua_state()) > 1) {
@@ -692,15 +954,23 @@ std::size_t output_flex_t::way_cache_t::add_nodes(middle_query_t const &middle)
 }
 
 bool output_flex_t::relation_cache_t::init(middle_query_t const &middle,
-                                           osmid_t id)
+                                           osmid_t id,
+                                           relation_lru_cache_t *lru)
 {
     m_relation_buffer.clear();
     m_members_buffer.clear();
+    m_lru = nullptr;
+
+    if (lru && lru->get(id, &m_relation_buffer, &m_members_buffer)) {
+        m_relation = &m_relation_buffer.get<osmium::Relation>(0);
+        return true;
+    }
 
     if (!middle.relation_get(id, &m_relation_buffer)) {
         return false;
     }
     m_relation = &m_relation_buffer.get<osmium::Relation>(0);
+    m_lru = lru;
     return true;
 }
 
@@ -708,6 +978,7 @@ void output_flex_t::relation_cache_t::init(osmium::Relation const &relation)
 {
     m_relation_buffer.clear();
     m_members_buffer.clear();
+    m_lru = nullptr;
 
     m_relation = &relation;
 }
@@ -732,6 +1003,10 @@ bool output_flex_t::relation_cache_t::add_members(middle_query_t const &middle)
         for (auto &way : m_members_buffer.select<osmium::Way>()) {
             get_nodes(middle, &way);
         }
+
+        if (m_lru) {
+            m_lru->add(m_relation->id(), m_relation_buffer, m_members_buffer);
+        }
     }
 
     return true;
@@ -777,7 +1052,17 @@ int output_flex_t::table_insert()
     }
 
     auto const num_params = lua_gettop(lua_state());
-    if (num_params != 2) {
+    if (m_in_batch) {
+        if (num_params != 3) {
+            throw fmt_error("Need three parameters in {}(): The "
+                            "osm2pgsql.Table, the row data, and the object.",
+                            m_calling_context == calling_context::process_node
+                                ? "process_node_batch"
+                                : "process_way_batch");
+        }
+        select_batch_object(3);
+        lua_settop(lua_state(), 2);
+    } else if (num_params != 2) {
         throw std::runtime_error{
             "Need two parameters: The osm2pgsql.Table and the row data."};
     }
@@ -793,37 +1078,113 @@ int output_flex_t::table_insert()
 
     auto const &table = table_connection.table();
     auto const &object = check_and_get_context_object(table);
+
+    flex_lua_profile_t::scope_t const profile_scope{
+        m_lua_profile.get(), flex_lua_profile_t::category::insert,
+        table.name()};
+
     osmid_t const id = table.map_id(object.type(), object.id());
 
-    table_connection.new_line();
-    auto *copy_mgr = table_connection.copy_mgr();
+    // The key calculated from the geometry decides the partition the row
+    // goes into and the order when sorting.
+    quadkey_t geom_key;
+    if (table.partitioned() || table_connection.sorting()) {
+        geom_key = flex_sort_key(lua_state(), table.geom_column());
+    }
+
+    // Rows in ephemeral tables are only checked and used for expiry, they
+    // are never written anywhere.
+    db_copy_mgr_t<db_deleter_by_type_and_id_t> *copy_mgr = nullptr;
+    if (!table.ephemeral()) {
+        table_connection.new_line(geom_key);
+        copy_mgr = table_connection.copy_mgr();
+    }
+
+    // Tiles are expired into m_row_expire_tiles first and only added to the
+    // other expired tiles after all columns have been written, so that a
+    // row rejected because of a later column doesn't expire anything.
+    for (auto &expire_tiles : m_row_expire_tiles) {
+        expire_tiles.clear();
+    }
+    auto *expire = &m_row_expire_tiles;
+    int64_t row_hash = 0;
 
     try {
         for (auto const &column : table_connection.table().columns()) {
             if (column.create_only()) {
                 continue;
             }
-            if (column.type() == table_column_type::id_type) {
-                copy_mgr->add_column(type_to_char(object.type()));
+            if (table.ephemeral()) {
+                flex_expire_column(lua_state(), column, expire);
+            } else if (column.type() == table_column_type::id_type) {
+                flex_write_text(copy_mgr, type_to_char(object.type()));
             } else if (column.type() == table_column_type::id_num) {
-                copy_mgr->add_column(id);
+                flex_write_integer(copy_mgr, column, id);
+            } else if (column.type() == table_column_type::partition) {
+                flex_write_integer(
+                    copy_mgr, column,
+                    static_cast<int64_t>(table.partition_for(geom_key)));
+            } else if (column.type() == table_column_type::row_hash) {
+                // This is always the last column, so the hash covers the
+                // contents of all other columns.
+                row_hash = flex_row_hash(copy_mgr->current_line());
+                flex_write_integer(copy_mgr, column, row_hash);
+            } else if (column.is_derived()) {
+                flex_write_derived_column(
+                    lua_state(), copy_mgr, column,
+                    table.columns()[column.derived_from()], expire);
             } else {
-                flex_write_column(lua_state(), copy_mgr, column,
-                                  &m_expire_tiles);
+                flex_write_column(lua_state(), copy_mgr, column, expire);
             }
         }
         table_connection.increment_insert_counter();
     } catch (not_null_exception_t const &e) {
-        copy_mgr->rollback_line();
+        if (copy_mgr) {
+            copy_mgr->rollback_line();
+        }
         lua_pushboolean(lua_state(), false);
         lua_pushliteral(lua_state(), "null value in not null column.");
         luaX_pushstring(lua_state(), e.column().name());
-        push_osm_object_to_lua_stack(lua_state(), object);
+        push_osm_object_to_lua_stack(lua_state(), object,
+                                     m_string_cache.get(), m_lazy_objects,
+                                     m_ffi_objects);
         table_connection.increment_not_null_error_counter();
         return 4;
+    } catch (invalid_geometry_exception_t const &e) {
+        if (copy_mgr) {
+            copy_mgr->rollback_line();
+        }
+        lua_pushboolean(lua_state(), false);
+        lua_pushliteral(lua_state(), "invalid geometry.");
+        luaX_pushstring(lua_state(), e.column().name());
+        push_osm_object_to_lua_stack(lua_state(), object,
+                                     m_string_cache.get(), m_lazy_objects,
+                                     m_ffi_objects);
+        table_connection.increment_invalid_geometry_counter();
+        return 4;
+    }
+
+    if (table.has_columns_with_expire()) {
+        auto &target = table_connection.detecting_changes()
+                           ? m_held_expire_tiles
+                           : m_expire_tiles;
+        for (std::size_t i = 0; i < target.size(); ++i) {
+            target[i].append_and_clear(&m_row_expire_tiles[i]);
+        }
     }
 
-    copy_mgr->finish_line();
+    if (table.ephemeral()) {
+        lua_pushboolean(lua_state(), true);
+        return 1;
+    }
+
+    if (table_connection.detecting_changes()) {
+        table_connection.hold_line(row_hash);
+    } else if (table_connection.sorting()) {
+        table_connection.finish_sorted_line(geom_key);
+    } else {
+        table_connection.finish_line();
+    }
 
     lua_pushboolean(lua_state(), true);
     return 1;
@@ -831,6 +1192,10 @@ int output_flex_t::table_insert()
 
 void output_flex_t::call_lua_function(prepared_lua_function_t func)
 {
+    flex_lua_profile_t::scope_t const profile_scope{
+        m_lua_profile.get(), flex_lua_profile_t::category::callback,
+        func.name()};
+
     lua_pushvalue(lua_state(), func.index());
     if (luaX_pcall(lua_state(), 0, func.nresults())) {
         throw fmt_error("Failed to execute Lua function 'osm2pgsql.{}': {}.",
@@ -843,11 +1208,21 @@ void output_flex_t::call_lua_function(prepared_lua_function_t func,
 {
     m_calling_context = func.context();
 
-    lua_pushvalue(lua_state(), func.index());          // the function to call
-    push_osm_object_to_lua_stack(lua_state(), object); // the single argument
+    flex_lua_profile_t::scope_t const profile_scope{
+        m_lua_profile.get(), flex_lua_profile_t::category::callback,
+        func.name()};
+
+    lua_pushvalue(lua_state(), func.index()); // the function to call
+    push_osm_object_to_lua_stack(lua_state(), object, m_string_cache.get(),
+                                 m_lazy_objects,
+                                 m_ffi_objects); // the single argument
 
     luaX_set_context(lua_state(), this);
-    if (luaX_pcall(lua_state(), 1, func.nresults())) {
+    bool const failed = luaX_pcall(lua_state(), 1, func.nresults()) != 0;
+    if (m_lazy_objects || m_ffi_objects) {
+        clear_callback_objects(lua_state());
+    }
+    if (failed) {
         throw fmt_error("Failed to execute Lua function 'osm2pgsql.{}': {}.",
                         func.name(), lua_tostring(lua_state(), -1));
     }
@@ -869,9 +1244,116 @@ void output_flex_t::get_mutex_and_call_lua_function(
     call_lua_function(func, object);
 }
 
+void output_flex_t::call_batch_function(
+    prepared_lua_function_t func,
+    std::vector<osmium::OSMObject const *> const &objects)
+{
+    std::lock_guard<std::mutex> const guard{lua_mutex};
+
+    m_calling_context = func.context();
+    m_in_batch = true;
+
+    flex_lua_profile_t::scope_t const profile_scope{
+        m_lua_profile.get(), flex_lua_profile_t::category::callback,
+        func.name()};
+
+    lua_pushvalue(lua_state(), func.index());
+    luaX_push_array(lua_state(), objects,
+                    [&](osmium::OSMObject const *object) {
+                        push_osm_object_to_lua_stack(
+                            lua_state(), *object, m_string_cache.get(),
+                            m_lazy_objects, m_ffi_objects);
+                        register_callback_object(lua_state(), *object);
+                    });
+
+    luaX_set_context(lua_state(), this);
+    bool const failed = luaX_pcall(lua_state(), 1, func.nresults()) != 0;
+    clear_callback_objects(lua_state());
+
+    m_in_batch = false;
+    m_context_node = nullptr;
+    m_way_cache.select(nullptr);
+    m_calling_context = calling_context::main;
+
+    if (failed) {
+        throw fmt_error("Failed to execute Lua function 'osm2pgsql.{}': {}.",
+                        func.name(), lua_tostring(lua_state(), -1));
+    }
+}
+
+void output_flex_t::add_to_batch(prepared_lua_function_t func,
+                                 osmium::OSMObject const &object)
+{
+    // In append mode the rows must be written right away, because they
+    // are needed for change detection. And there are usually not that
+    // many objects anyway.
+    if (get_options()->append) {
+        call_batch_function(func, {&object});
+        return;
+    }
+
+    if (!m_batch) {
+        m_batch = osmium::memory::Buffer{
+            1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    }
+
+    m_batch.add_item(object);
+    m_batch.commit();
+
+    if (++m_batch_size >= BATCH_SIZE) {
+        flush_batch(func);
+    }
+}
+
+void output_flex_t::flush_batch(prepared_lua_function_t func)
+{
+    if (m_batch_size == 0) {
+        return;
+    }
+
+    std::vector<osmium::OSMObject const *> objects;
+    objects.reserve(m_batch_size);
+    for (auto const &object : m_batch.select<osmium::OSMObject>()) {
+        objects.push_back(&object);
+    }
+
+    call_batch_function(func, objects);
+
+    m_batch.clear();
+    m_batch_size = 0;
+}
+
+void output_flex_t::select_batch_object(int index)
+{
+    if (!m_in_batch) {
+        return;
+    }
+
+    auto const *const object = get_callback_object(lua_state(), index);
+
+    if (m_calling_context == calling_context::process_node) {
+        if (!object || object->type() != osmium::item_type::node) {
+            throw std::runtime_error{
+                "Expected a node object from the current batch."};
+        }
+        m_context_node = static_cast<osmium::Node const *>(object);
+        return;
+    }
+
+    if (!object || object->type() != osmium::item_type::way) {
+        throw std::runtime_error{
+            "Expected a way object from the current batch."};
+    }
+
+    // The ways are in a buffer owned by this output, adding node
+    // locations to them is okay.
+    m_way_cache.select(
+        const_cast<osmium::Way *>(static_cast<osmium::Way const *>(object)));
+}
+
 void output_flex_t::pending_way(osmid_t id)
 {
-    if (!m_process_way && !m_process_untagged_way) {
+    if (!m_process_way && !m_process_way_batch && !m_process_untagged_way) {
         return;
     }
 
@@ -879,17 +1361,25 @@ void output_flex_t::pending_way(osmid_t id)
         return;
     }
 
-    way_delete(id);
-    auto const &func = m_way_cache.get().tags().empty() ? m_process_untagged_way
-                                                        : m_process_way;
-    if (func) {
-        get_mutex_and_call_lua_function(func, m_way_cache.get());
+    delete_from_tables(osmium::item_type::way, id, true);
+    auto const &way = m_way_cache.get();
+    if (!filtered_out(way)) {
+        if (m_process_way_batch && !way.tags().empty()) {
+            call_batch_function(m_process_way_batch, {&way});
+        } else {
+            auto const &func =
+                way.tags().empty() ? m_process_untagged_way : m_process_way;
+            if (func) {
+                get_mutex_and_call_lua_function(func, way);
+            }
+        }
     }
+    finish_change_detection();
 }
 
 void output_flex_t::select_relation_members()
 {
-    if (!m_select_relation_members) {
+    if (!m_select_relation_members || filtered_out(m_relation_cache.get())) {
         return;
     }
 
@@ -936,7 +1426,7 @@ void output_flex_t::process_relation()
     auto const &func = m_relation_cache.get().tags().empty()
                            ? m_process_untagged_relation
                            : m_process_relation;
-    if (func) {
+    if (func && !filtered_out(m_relation_cache.get())) {
         get_mutex_and_call_lua_function(func, m_relation_cache.get());
     }
 }
@@ -948,13 +1438,14 @@ void output_flex_t::pending_relation(osmid_t id)
         return;
     }
 
-    if (!m_relation_cache.init(middle(), id)) {
+    if (!m_relation_cache.init(middle(), id, m_relation_lru.get())) {
         return;
     }
 
     select_relation_members();
-    delete_from_tables(osmium::item_type::relation, id);
+    delete_from_tables(osmium::item_type::relation, id, true);
     process_relation();
+    finish_change_detection();
 }
 
 void output_flex_t::pending_relation_stage1c(osmid_t id)
@@ -963,7 +1454,7 @@ void output_flex_t::pending_relation_stage1c(osmid_t id)
         return;
     }
 
-    if (!m_relation_cache.init(middle(), id)) {
+    if (!m_relation_cache.init(middle(), id, m_relation_lru.get())) {
         return;
     }
 
@@ -981,6 +1472,8 @@ void output_flex_t::sync()
 
 void output_flex_t::after_nodes()
 {
+    flush_batch(m_process_node_batch);
+
     if (m_after_nodes) {
         get_mutex_and_call_lua_function(m_after_nodes);
     }
@@ -990,6 +1483,8 @@ void output_flex_t::after_nodes()
 
 void output_flex_t::after_ways()
 {
+    flush_batch(m_process_way_batch);
+
     if (m_after_ways) {
         get_mutex_and_call_lua_function(m_after_ways);
     }
@@ -1008,14 +1503,28 @@ void output_flex_t::after_relations()
 
 void output_flex_t::stop()
 {
+    if (m_lua_profile) {
+        m_lua_profile->log_summary();
+    }
+
+    log_debug("Lua string cache: {} hits, {} misses.", m_string_cache->hits(),
+              m_string_cache->misses());
+
+    if (m_relation_lru) {
+        log_debug("Relation cache: {} hits, {} misses.", m_relation_lru->hits(),
+                  m_relation_lru->misses());
+    }
+
+    std::vector<std::shared_future<std::chrono::microseconds>> synced;
     for (auto &table : m_table_connections) {
-        table.task_set(thread_pool().submit([&]() {
-            pg_conn_t const db_connection{get_options()->connection_params,
-                                          "out.flex.stop"};
-            table.stop(db_connection,
-                       get_options()->slim && !get_options()->droptemp,
-                       get_options()->append);
-        }));
+        synced.push_back(
+            table.task_add(thread_pool().submit([&]() { table.sync(); })));
+    }
+
+    if (!get_options()->append) {
+        m_postprocessing_progress = std::make_unique<postprocessing_progress_t>(
+            get_options()->connection_params);
+        add_postprocessing_tasks(synced);
     }
 
     assert(m_expire_outputs->size() == m_expire_tiles.size());
@@ -1032,6 +1541,112 @@ void output_flex_t::stop()
     }
 }
 
+void output_flex_t::add_postprocessing_tasks(
+    std::vector<std::shared_future<std::chrono::microseconds>> const &synced)
+{
+    bool const updateable = get_options()->slim && !get_options()->droptemp;
+
+    // Post-processing is done in several tasks per table, so that the
+    // partitions and indexes of a table can be handled in parallel. Tasks
+    // are run in the order they are submitted, so if we submit all tasks of
+    // one phase before the tasks of the next phase, every task a task
+    // depends on has been started before it. That's why waiting on them is
+    // safe.
+
+    // For each table and partition: The task after which the partition is
+    // ready for the next step.
+    std::vector<std::vector<std::shared_future<std::chrono::microseconds>>>
+        ready;
+    for (std::size_t i = 0; i < m_table_connections.size(); ++i) {
+        auto &table = m_table_connections[i];
+        auto &table_ready = ready.emplace_back(table.table().num_partitions(),
+                                               synced[i]);
+        if (table.table().ephemeral()) {
+            table_ready.clear();
+            continue;
+        }
+        if (!table.table().cluster_by_geom()) {
+            continue;
+        }
+        for (std::size_t n = 0; n < table_ready.size(); ++n) {
+            table_ready[n] = table.task_add(
+                thread_pool().submit([&, n, done = synced[i]]() {
+                    done.get();
+                    pg_conn_t const db_connection{
+                        get_options()->connection_params, "out.flex.cluster"};
+                    table.cluster(db_connection, n);
+                }));
+        }
+    }
+
+    if (get_options()->unlogged) {
+        for (std::size_t i = 0; i < m_table_connections.size(); ++i) {
+            auto &table = m_table_connections[i];
+            if (table.table().cluster_by_geom()) {
+                continue;
+            }
+            for (std::size_t n = 0; n < ready[i].size(); ++n) {
+                ready[i][n] = table.task_add(
+                    thread_pool().submit([&, n, done = ready[i][n]]() {
+                        done.get();
+                        pg_conn_t const db_connection{
+                            get_options()->connection_params,
+                            "out.flex.logged"};
+                        table.set_logged(db_connection, n);
+                    }));
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < m_table_connections.size(); ++i) {
+        auto &table = m_table_connections[i];
+
+        if (table.table().indexes().empty() && !table.table().ephemeral()) {
+            log_info("No indexes to create on table '{}'.",
+                     table.table().name());
+        }
+
+        for (std::size_t n = 0; n < ready[i].size(); ++n) {
+            for (auto const &index : table.table().indexes()) {
+                table.task_add(
+                    thread_pool().submit([&, n, done = ready[i][n]]() {
+                        done.get();
+                        pg_conn_t const db_connection{
+                            get_options()->connection_params,
+                            "out.flex.index"};
+                        table.create_index(db_connection, index, n);
+                    }));
+            }
+
+            if (table.needs_id_index(updateable)) {
+                table.task_add(
+                    thread_pool().submit([&, n, done = ready[i][n]]() {
+                        done.get();
+                        pg_conn_t const db_connection{
+                            get_options()->connection_params,
+                            "out.flex.index"};
+                        table.create_id_index(db_connection, n);
+                    }));
+            }
+        }
+    }
+
+    for (auto &table : m_table_connections) {
+        if (table.table().ephemeral()) {
+            continue;
+        }
+        table.task_add(
+            thread_pool().submit([&, futures = table.task_futures()]() {
+                for (auto const &future : futures) {
+                    future.get();
+                }
+                pg_conn_t const db_connection{get_options()->connection_params,
+                                              "out.flex.analyze"};
+                table.analyze(db_connection);
+            }));
+    }
+}
+
 void output_flex_t::wait()
 {
     std::exception_ptr eptr;
@@ -1046,6 +1661,11 @@ void output_flex_t::wait()
         }
     }
 
+    if (m_postprocessing_progress) {
+        m_postprocessing_progress->stop();
+        m_postprocessing_progress.reset();
+    }
+
     if (eptr) {
         log_error("Error while doing postprocessing on table '{}':",
                   table_with_error->name());
@@ -1055,10 +1675,17 @@ void output_flex_t::wait()
 
 void output_flex_t::node_add(osmium::Node const &node)
 {
+    if (m_process_node_batch && !node.tags().empty()) {
+        if (!filtered_out(node)) {
+            add_to_batch(m_process_node_batch, node);
+        }
+        return;
+    }
+
     auto const &func =
         node.tags().empty() ? m_process_untagged_node : m_process_node;
 
-    if (!func) {
+    if (!func || filtered_out(node)) {
         return;
     }
 
@@ -1071,10 +1698,17 @@ void output_flex_t::way_add(osmium::Way *way)
 {
     assert(way);
 
+    if (m_process_way_batch && !way->tags().empty()) {
+        if (!filtered_out(*way)) {
+            add_to_batch(m_process_way_batch, *way);
+        }
+        return;
+    }
+
     auto const &func =
         way->tags().empty() ? m_process_untagged_way : m_process_way;
 
-    if (!func) {
+    if (!func || filtered_out(*way)) {
         return;
     }
 
@@ -1087,7 +1721,7 @@ void output_flex_t::relation_add(osmium::Relation const &relation)
     auto const &func = relation.tags().empty() ? m_process_untagged_relation
                                                : m_process_relation;
 
-    if (!func) {
+    if (!func || filtered_out(relation)) {
         return;
     }
 
@@ -1124,11 +1758,43 @@ void output_flex_t::delete_from_table(table_connection_t *table_connection,
     table_connection->delete_rows_with(type, id);
 }
 
-void output_flex_t::delete_from_tables(osmium::item_type type, osmid_t osm_id)
+void output_flex_t::delete_from_tables(osmium::item_type type, osmid_t osm_id,
+                                       bool detect_changes)
+{
+    for (auto &table : m_table_connections) {
+        // Nothing is stored for ephemeral tables, so there are no rows to
+        // delete and no old geometries to expire.
+        if (table.table().matches_type(type) && table.table().has_id_column() &&
+            !table.table().ephemeral()) {
+            if (detect_changes && table.table().detect_changes()) {
+                table.start_change_detection(m_db_connection, type, osm_id);
+            } else {
+                delete_from_table(&table, m_db_connection, type, osm_id);
+            }
+        }
+    }
+}
+
+void output_flex_t::finish_change_detection()
 {
+    bool changed = false;
     for (auto &table : m_table_connections) {
-        if (table.table().matches_type(type) && table.table().has_id_column()) {
-            delete_from_table(&table, m_db_connection, type, osm_id);
+        if (!table.detecting_changes()) {
+            continue;
+        }
+        if (table.has_changes()) {
+            delete_from_table(&table, m_db_connection, table.detect_type(),
+                              table.detect_id());
+            changed = true;
+        }
+        table.finish_change_detection();
+    }
+
+    for (std::size_t i = 0; i < m_held_expire_tiles.size(); ++i) {
+        if (changed) {
+            m_expire_tiles[i].append_and_clear(&m_held_expire_tiles[i]);
+        } else {
+            m_held_expire_tiles[i].clear();
         }
     }
 }
@@ -1186,26 +1852,31 @@ void output_flex_t::relation_delete(osmid_t osm_id)
 
 void output_flex_t::node_modify(osmium::Node const &node)
 {
-    node_delete(node.id());
+    delete_from_tables(osmium::item_type::node, node.id(), true);
     node_add(node);
+    finish_change_detection();
 }
 
 void output_flex_t::way_modify(osmium::Way *way)
 {
-    way_delete(way->id());
+    delete_from_tables(osmium::item_type::way, way->id(), true);
     way_add(way);
+    finish_change_detection();
 }
 
 void output_flex_t::relation_modify(osmium::Relation const &rel)
 {
-    relation_delete(rel.id());
+    select_relation_members(rel.id());
+    delete_from_tables(osmium::item_type::relation, rel.id(), true);
     relation_add(rel);
+    finish_change_detection();
 }
 
 void output_flex_t::start()
 {
     for (auto &table : m_table_connections) {
-        table.start(m_db_connection, get_options()->append);
+        table.start(m_db_connection, get_options()->append,
+                    get_options()->unlogged);
     }
 
     for (auto &locator : *m_locators) {
@@ -1221,8 +1892,14 @@ output_flex_t::output_flex_t(output_flex_t const *other,
   m_db_connection(get_options()->connection_params, "out.flex.thread"),
   m_stage2_way_ids(other->m_stage2_way_ids),
   m_copy_thread(std::move(copy_thread)), m_lua_state(other->m_lua_state),
+  m_lua_profile(other->m_lua_profile),
+  m_string_cache(other->m_string_cache),
+  m_relation_lru(other->m_relation_lru),
   m_area_buffer(1024, osmium::memory::Buffer::auto_grow::yes),
-  m_process_node(other->m_process_node), m_process_way(other->m_process_way),
+  m_process_node(other->m_process_node),
+  m_process_node_batch(other->m_process_node_batch),
+  m_process_way(other->m_process_way),
+  m_process_way_batch(other->m_process_way_batch),
   m_process_relation(other->m_process_relation),
   m_process_untagged_node(other->m_process_untagged_node),
   m_process_untagged_way(other->m_process_untagged_way),
@@ -1232,7 +1909,9 @@ output_flex_t::output_flex_t(output_flex_t const *other,
   m_process_deleted_relation(other->m_process_deleted_relation),
   m_select_relation_members(other->m_select_relation_members),
   m_after_nodes(other->m_after_nodes), m_after_ways(other->m_after_ways),
-  m_after_relations(other->m_after_relations)
+  m_after_relations(other->m_after_relations),
+  m_lazy_objects(other->m_lazy_objects), m_ffi_objects(other->m_ffi_objects),
+  m_tag_filter(other->m_tag_filter)
 {
     for (auto &table : *m_tables) {
         table.prepare(m_db_connection);
@@ -1243,6 +1922,12 @@ output_flex_t::output_flex_t(output_flex_t const *other,
         m_expire_tiles.emplace_back(
             expire_output.maxzoom(),
             reprojection_t::create_projection(PROJ_SPHERE_MERC));
+        m_held_expire_tiles.emplace_back(
+            expire_output.maxzoom(),
+            reprojection_t::create_projection(PROJ_SPHERE_MERC));
+        m_row_expire_tiles.emplace_back(
+            expire_output.maxzoom(),
+            reprojection_t::create_projection(PROJ_SPHERE_MERC));
     }
 }
 
@@ -1262,6 +1947,17 @@ output_flex_t::output_flex_t(std::shared_ptr<middle_query_t> const &mid,
   m_copy_thread(std::make_shared<db_copy_thread_t>(options.connection_params)),
   m_area_buffer(1024, osmium::memory::Buffer::auto_grow::yes)
 {
+    if (!options.lua_profile.empty()) {
+        m_lua_profile = std::make_shared<flex_lua_profile_t>();
+    }
+
+    m_string_cache = std::make_shared<lua_string_cache_t>();
+
+    if (options.append) {
+        m_relation_lru =
+            std::make_shared<relation_lru_cache_t>(RELATION_LRU_CACHE_SIZE);
+    }
+
     init_lua(options.style, properties);
 
     // If the osm2pgsql.select_relation_members() Lua function is defined
@@ -1298,6 +1994,19 @@ output_flex_t::output_flex_t(std::shared_ptr<middle_query_t> const &mid,
         }
     }
 
+    // Ephemeral tables don't keep the old geometries in the database, so
+    // they can't be expired when an object changes or is deleted.
+    if (options.append) {
+        for (auto const &table : *m_tables) {
+            if (table.ephemeral() && table.has_columns_with_expire()) {
+                log_warn("Ephemeral table '{}' only expires tiles for new"
+                         " geometries, not for old geometries of changed"
+                         " or deleted objects.",
+                         table.name());
+            }
+        }
+    }
+
     write_expire_output_list_to_debug_log(*m_expire_outputs);
     write_table_list_to_debug_log(*m_tables);
 
@@ -1309,6 +2018,12 @@ output_flex_t::output_flex_t(std::shared_ptr<middle_query_t> const &mid,
         m_expire_tiles.emplace_back(
             expire_output.maxzoom(),
             reprojection_t::create_projection(PROJ_SPHERE_MERC));
+        m_held_expire_tiles.emplace_back(
+            expire_output.maxzoom(),
+            reprojection_t::create_projection(PROJ_SPHERE_MERC));
+        m_row_expire_tiles.emplace_back(
+            expire_output.maxzoom(),
+            reprojection_t::create_projection(PROJ_SPHERE_MERC));
     }
 
     create_expire_tables(*m_expire_outputs, get_options()->connection_params);
@@ -1363,6 +2078,25 @@ void output_flex_t::init_lua(std::string const &filename,
          {"as_multipolygon", lua_trampoline_app_as_multipolygon},
          {"as_geometrycollection", lua_trampoline_app_as_geometrycollection}});
 
+    lua_newtable(lua_state());
+    lua_setfield(lua_state(), LUA_REGISTRYINDEX, OSM2PGSQL_CALLBACK_OBJECTS);
+
+#ifdef HAVE_LUAJIT
+    lua_getglobal(lua_state(), "osm2pgsql");
+    add_ffi_functions(lua_state());
+    lua_pop(lua_state(), 1);
+#endif
+
+    if (m_lua_profile) {
+        m_lua_profile->wrap_functions(lua_state(), OSM2PGSQL_OSMOBJECT_CLASS,
+                                      "OSMObject");
+        m_lua_profile->wrap_functions(lua_state(), OSM2PGSQL_GEOMETRY_CLASS,
+                                      "Geometry");
+        if (get_options()->lua_profile == "lines") {
+            m_lua_profile->enable_line_sampling(lua_state());
+        }
+    }
+
     // Load compiled in init.lua
     if (luaL_dostring(lua_state(), lua_init())) {
         throw fmt_error("Internal error in Lua setup: {}.",
@@ -1382,8 +2116,12 @@ void output_flex_t::init_lua(std::string const &filename,
 
     m_process_node = prepared_lua_function_t{
         lua_state(), calling_context::process_node, "process_node"};
+    m_process_node_batch = prepared_lua_function_t{
+        lua_state(), calling_context::process_node, "process_node_batch"};
     m_process_way = prepared_lua_function_t{
         lua_state(), calling_context::process_way, "process_way"};
+    m_process_way_batch = prepared_lua_function_t{
+        lua_state(), calling_context::process_way, "process_way_batch"};
     m_process_relation = prepared_lua_function_t{
         lua_state(), calling_context::process_relation, "process_relation"};
 
@@ -1414,6 +2152,62 @@ void output_flex_t::init_lua(std::string const &filename,
     m_after_relations = prepared_lua_function_t{
         lua_state(), calling_context::main, "after_relations"};
 
+    if (m_process_node && m_process_node_batch) {
+        throw std::runtime_error{"Only one of osm2pgsql.process_node and "
+                                 "osm2pgsql.process_node_batch can be "
+                                 "defined."};
+    }
+
+    if (m_process_way && m_process_way_batch) {
+        throw std::runtime_error{"Only one of osm2pgsql.process_way and "
+                                 "osm2pgsql.process_way_batch can be "
+                                 "defined."};
+    }
+
+    lua_getfield(lua_state(), 1, "lazy_objects");
+    if (!lua_isnil(lua_state(), -1)) {
+        if (!lua_isboolean(lua_state(), -1)) {
+            throw std::runtime_error{
+                "osm2pgsql.lazy_objects must be a boolean."};
+        }
+        m_lazy_objects = lua_toboolean(lua_state(), -1);
+    }
+    lua_pop(lua_state(), 1);
+
+    lua_getfield(lua_state(), 1, "ffi_objects");
+    if (!lua_isnil(lua_state(), -1)) {
+        if (!lua_isboolean(lua_state(), -1)) {
+            throw std::runtime_error{
+                "osm2pgsql.ffi_objects must be a boolean."};
+        }
+        m_ffi_objects = lua_toboolean(lua_state(), -1);
+#ifndef HAVE_LUAJIT
+        if (m_ffi_objects) {
+            throw std::runtime_error{"osm2pgsql.ffi_objects can only be used "
+                                     "if osm2pgsql is built with LuaJIT."};
+        }
+#endif
+    }
+    lua_pop(lua_state(), 1);
+
+    lua_getfield(lua_state(), 1, "tag_filter");
+    if (!lua_isnil(lua_state(), -1)) {
+        setup_tag_filter(lua_state(), &m_tag_filter);
+    }
+    lua_pop(lua_state(), 1);
+
+    if (m_lazy_objects) {
+        log_debug("Using lazy OSM objects in Lua.");
+        luaL_getmetatable(lua_state(), OSM2PGSQL_OSMOBJECT_CLASS);
+        lua_pushlightuserdata(lua_state(), m_string_cache.get());
+        lua_pushcclosure(lua_state(), lua_lazy_object_index, 1);
+        lua_setfield(lua_state(), -2, "__index");
+        lua_getglobal(lua_state(), "next");
+        lua_pushcclosure(lua_state(), lua_lazy_object_pairs, 1);
+        lua_setfield(lua_state(), -2, "__pairs");
+        lua_pop(lua_state(), 1); // metatable
+    }
+
     lua_remove(lua_state(), 1); // global "osm2pgsql"
 }
 
@@ -1457,7 +2251,7 @@ void output_flex_t::reprocess_marked()
 
         for (auto &table : m_table_connections) {
             if (table.table().matches_type(osmium::item_type::way) &&
-                table.table().has_id_column()) {
+                table.table().has_id_column() && !table.table().ephemeral()) {
                 table.table().analyze(m_db_connection);
                 table.create_id_index(m_db_connection);
             }
@@ -1486,12 +2280,17 @@ void output_flex_t::reprocess_marked()
 
         for (osmid_t const id : *m_stage2_node_ids) {
             if (middle().node_get(id, &node_buffer)) {
-                node_delete(id);
-                if (m_process_node) {
-                    auto const &node = node_buffer.get<osmium::Node>(0);
-                    m_context_node = &node;
-                    get_mutex_and_call_lua_function(m_process_node, node);
+                delete_from_tables(osmium::item_type::node, id, true);
+                auto const &node = node_buffer.get<osmium::Node>(0);
+                if (!filtered_out(node)) {
+                    if (m_process_node) {
+                        m_context_node = &node;
+                        get_mutex_and_call_lua_function(m_process_node, node);
+                    } else if (m_process_node_batch) {
+                        call_batch_function(m_process_node_batch, {&node});
+                    }
                 }
+                finish_change_detection();
             }
             node_buffer.clear();
         }
@@ -1506,10 +2305,17 @@ void output_flex_t::reprocess_marked()
         if (!m_way_cache.init(middle(), id)) {
             continue;
         }
-        way_delete(id);
-        if (m_process_way) {
-            get_mutex_and_call_lua_function(m_process_way, m_way_cache.get());
+        delete_from_tables(osmium::item_type::way, id, true);
+        if (!filtered_out(m_way_cache.get())) {
+            if (m_process_way) {
+                get_mutex_and_call_lua_function(m_process_way,
+                                                m_way_cache.get());
+            } else if (m_process_way_batch) {
+                call_batch_function(m_process_way_batch,
+                                    {&m_way_cache.get()});
+            }
         }
+        finish_change_detection();
     }
 
     // We don't need these any more so can free the memory.
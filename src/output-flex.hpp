@@ -15,16 +15,21 @@
 #include "expire-tiles.hpp"
 #include "flex-table-column.hpp"
 #include "flex-table.hpp"
+#include "flex-tag-filter.hpp"
 #include "geom.hpp"
 #include "idlist.hpp"
 #include "locator.hpp"
 #include "output.hpp"
+#include "postprocessing-progress.hpp"
+#include "relation-lru-cache.hpp"
 
 #include <osmium/osm/item_type.hpp>
 
 #include <lua.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
@@ -32,7 +37,9 @@
 
 class db_copy_thread_t;
 class db_deleter_by_type_and_id_t;
+class flex_lua_profile_t;
 class geom_transform_t;
+class lua_string_cache_t;
 class thread_pool_t;
 struct options_t;
 
@@ -196,8 +203,42 @@ private:
     void get_mutex_and_call_lua_function(prepared_lua_function_t func,
                                          osmium::OSMObject const &object);
 
+    /**
+     * Aquire the lua_mutex and call the batch function func
+     * (process_node_batch() or process_way_batch()) with these objects.
+     */
+    void call_batch_function(
+        prepared_lua_function_t func,
+        std::vector<osmium::OSMObject const *> const &objects);
+
+    /**
+     * Add an object to the batch for the batch function func. Calls the
+     * function when the batch is full.
+     */
+    void add_to_batch(prepared_lua_function_t func,
+                      osmium::OSMObject const &object);
+
+    /// Call the batch function func for all objects still in the batch.
+    void flush_batch(prepared_lua_function_t func);
+
+    /**
+     * When called from inside a batch function, make the object at the
+     * specified position on the Lua stack the current node or way.
+     */
+    void select_batch_object(int index);
+
     void process_relation();
 
+    /**
+     * Is this object filtered out by the tag filter from the Lua config?
+     * Objects without tags are never filtered out.
+     */
+    bool filtered_out(osmium::OSMObject const &object) const noexcept
+    {
+        return !object.tags().empty() &&
+               !m_tag_filter.matches(object.type(), object.tags());
+    }
+
     void init_lua(std::string const &filename, properties_t const &properties);
 
     void check_context_and_state(char const *name, char const *context,
@@ -214,7 +255,30 @@ private:
                            pg_conn_t const &db_connection,
                            osmium::item_type type, osmid_t osm_id);
 
-    void delete_from_tables(osmium::item_type type, osmid_t osm_id);
+    /**
+     * Delete all rows of the specified object from all tables. If
+     * detect_changes is set, tables with change detection don't delete
+     * the rows immediately but start detecting changes instead. Call
+     * finish_change_detection() after adding the new rows in that case.
+     */
+    void delete_from_tables(osmium::item_type type, osmid_t osm_id,
+                            bool detect_changes = false);
+
+    /**
+     * Finish change detection on all tables: Tables where the rows for the
+     * object have changed get the old rows deleted and the new rows added.
+     * Tiles are only expired if something has changed.
+     */
+    void finish_change_detection();
+
+    /**
+     * Add the post-processing tasks after import (clustering, setting
+     * tables to LOGGED, index creation, analyze) to the thread pool. They
+     * wait for the tasks syncing each table given in synced.
+     */
+    void add_postprocessing_tasks(
+        std::vector<std::shared_future<std::chrono::microseconds>> const
+            &synced);
 
     lua_State *lua_state() noexcept { return m_lua_state.get(); }
 
@@ -224,6 +288,20 @@ private:
         bool init(middle_query_t const &middle, osmid_t id);
         void init(osmium::Way *way);
         std::size_t add_nodes(middle_query_t const &middle);
+
+        /**
+         * Make this way the current way. Unlike init() this doesn't clear
+         * the buffer and keeps the node locations already added if the way
+         * already is the current way.
+         */
+        void select(osmium::Way *way) noexcept
+        {
+            if (m_way != way) {
+                m_way = way;
+                m_num_way_nodes = std::numeric_limits<std::size_t>::max();
+            }
+        }
+
         osmium::Way const &get() const noexcept { return *m_way; }
 
     private:
@@ -237,7 +315,15 @@ private:
     class relation_cache_t
     {
     public:
-        bool init(middle_query_t const &middle, osmid_t id);
+        /**
+         * Get relation from the middle. If an LRU cache is given, the
+         * relation and its members are looked up there first, and the
+         * members are added to it when they are fetched from the middle.
+         * The LRU cache must only be used when the middle will not change
+         * any more.
+         */
+        bool init(middle_query_t const &middle, osmid_t id,
+                  relation_lru_cache_t *lru = nullptr);
         void init(osmium::Relation const &relation);
 
         /**
@@ -263,6 +349,7 @@ private:
         osmium::memory::Buffer m_members_buffer{
             32768, osmium::memory::Buffer::auto_grow::yes};
         osmium::Relation const *m_relation = nullptr;
+        relation_lru_cache_t *m_lru = nullptr;
 
     }; // relation_cache_t
 
@@ -291,8 +378,37 @@ private:
     // accessed while protected using the lua_mutex.
     std::shared_ptr<lua_State> m_lua_state;
 
+    // Timings of the Lua code if --log-lua-profile is used. This is shared
+    // between all clones of the output and must only be accessed while
+    // protected using the lua_mutex.
+    std::shared_ptr<flex_lua_profile_t> m_lua_profile;
+
+    // Cache for tag keys and values pushed into Lua. This is shared
+    // between all clones of the output, because it is tied to the Lua state,
+    // and must only be accessed while protected using the lua_mutex.
+    std::shared_ptr<lua_string_cache_t> m_string_cache;
+
+    // Cache for relations and their members processed in append mode. This
+    // is shared between all clones of the output, it does its own locking.
+    std::shared_ptr<relation_lru_cache_t> m_relation_lru;
+
     std::vector<expire_tiles_t> m_expire_tiles;
 
+    /**
+     * Tiles expired by rows added to tables while detecting changes. They
+     * are only moved to m_expire_tiles if the rows have actually changed.
+     */
+    std::vector<expire_tiles_t> m_held_expire_tiles;
+
+    /**
+     * Tiles expired by the row currently being added. They are only moved
+     * to m_expire_tiles or m_held_expire_tiles if the row is complete.
+     */
+    std::vector<expire_tiles_t> m_row_expire_tiles;
+
+    /// Reports progress of the post-processing while it is running.
+    std::unique_ptr<postprocessing_progress_t> m_postprocessing_progress;
+
     way_cache_t m_way_cache;
     relation_cache_t m_relation_cache;
     osmium::Node const *m_context_node = nullptr;
@@ -300,7 +416,9 @@ private:
     osmium::memory::Buffer m_area_buffer;
 
     prepared_lua_function_t m_process_node;
+    prepared_lua_function_t m_process_node_batch;
     prepared_lua_function_t m_process_way;
+    prepared_lua_function_t m_process_way_batch;
     prepared_lua_function_t m_process_relation;
 
     prepared_lua_function_t m_process_untagged_node;
@@ -324,6 +442,38 @@ private:
      * insert() command.
      */
     bool m_disable_insert = false;
+
+    /**
+     * Set from osm2pgsql.lazy_objects in the Lua config. If set the tags,
+     * way nodes, and relation members of OSM objects are only converted
+     * into Lua tables when they are accessed. With Lua 5.1 and LuaJIT
+     * pairs(object) only returns the fields already accessed, because they
+     * don't support the __pairs metamethod.
+     */
+    bool m_lazy_objects = false;
+
+    /**
+     * Set from osm2pgsql.ffi_objects in the Lua config. If set OSM objects
+     * get a pointer to the osmium object which is used by the functions in
+     * osm2pgsql.ffi. Only available when built with LuaJIT.
+     */
+    bool m_ffi_objects = false;
+
+    /**
+     * Set from osm2pgsql.tag_filter in the Lua config. Tagged objects not
+     * matching this filter are not passed to the Lua callbacks.
+     */
+    flex_tag_filter_t m_tag_filter;
+
+    /**
+     * Nodes or ways collected for the next call to process_node_batch() or
+     * process_way_batch(). All nodes are flushed before the first way.
+     */
+    osmium::memory::Buffer m_batch;
+    std::size_t m_batch_size = 0;
+
+    /// Set while process_node_batch() or process_way_batch() is running.
+    bool m_in_batch = false;
 };
 
 int lua_trampoline_table_insert(lua_State *lua_state);
@@ -53,9 +53,10 @@ double calculate_area(bool reproject_area, geom::geometry_t const &geom4326,
 {
     static thread_local auto const proj3857 =
         reprojection_t::create_projection(PROJ_SPHERE_MERC);
+    static thread_local geom::geometry_t ogeom;
 
     if (reproject_area) {
-        auto const ogeom = geom::transform(geom4326, *proj3857);
+        geom::transform(&ogeom, geom4326, *proj3857);
         return geom::area(ogeom);
     }
     return geom::area(projected_geom);
@@ -97,14 +98,14 @@ void output_pgsql_t::pgsql_out_way(osmium::Way const &way, taglist_t *tags,
 {
     if (polygon && !way.nodes().empty() && way.is_closed()) {
         auto const geom = geom::create_polygon(way, &m_area_buffer);
-        auto const projected_geom = geom::transform(geom, *m_proj);
+        geom::transform(&m_projected_geom, geom, *m_proj);
 
-        auto const wkb = geom_to_ewkb(projected_geom);
+        auto const wkb = geom_to_ewkb(m_projected_geom);
         if (!wkb.empty()) {
-            m_expire.from_geometry_if_3857(projected_geom, m_expire_config);
+            m_expire.from_geometry_if_3857(m_projected_geom, m_expire_config);
             if (m_enable_way_area) {
                 double const area = calculate_area(
-                    get_options()->reproject_area, geom, projected_geom);
+                    get_options()->reproject_area, geom, m_projected_geom);
                 util::double_to_buffer_t const tmp{area};
                 tags->set("way_area", tmp.c_str());
             }
@@ -310,12 +311,12 @@ void output_pgsql_t::pgsql_process_relation(osmium::Relation const &rel)
             geom::create_multipolygon(rel, m_buffer, &m_area_buffer),
             !get_options()->enable_multi);
         for (auto const &sgeom : geoms) {
-            auto const projected_geom = geom::transform(sgeom, *m_proj);
-            m_expire.from_geometry_if_3857(projected_geom, m_expire_config);
-            auto const wkb = geom_to_ewkb(projected_geom);
+            geom::transform(&m_projected_geom, sgeom, *m_proj);
+            m_expire.from_geometry_if_3857(m_projected_geom, m_expire_config);
+            auto const wkb = geom_to_ewkb(m_projected_geom);
             if (m_enable_way_area) {
                 double const area = calculate_area(
-                    get_options()->reproject_area, sgeom, projected_geom);
+                    get_options()->reproject_area, sgeom, m_projected_geom);
                 util::double_to_buffer_t const tmp{area};
                 outtags.set("way_area", tmp.c_str());
             }
@@ -60,6 +60,8 @@ public:
     clone(std::shared_ptr<middle_query_t> const &mid,
           std::shared_ptr<db_copy_thread_t> const &copy_thread) const override;
 
+    bool supports_parallel_import() const noexcept override { return true; }
+
     void start() override;
     void stop() override;
     void sync() override;
@@ -113,6 +115,10 @@ private:
     osmium::memory::Buffer m_buffer;
     osmium::memory::Buffer m_rels_buffer;
     osmium::memory::Buffer m_area_buffer;
+
+    // Reused for reprojected polygons to avoid allocating memory for
+    // every object.
+    geom::geometry_t m_projected_geom;
 };
 
 #endif // OSM2PGSQL_OUTPUT_PGSQL_HPP
@@ -60,6 +60,12 @@ public:
      */
     void free_middle_references();
 
+    /**
+     * Can ways and relations be processed by clones of this output in
+     * several threads in parallel during import?
+     */
+    virtual bool supports_parallel_import() const noexcept { return false; }
+
     virtual void start() = 0;
     virtual void stop() = 0;
     virtual void sync() = 0;
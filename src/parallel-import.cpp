@@ -0,0 +1,225 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "parallel-import.hpp"
+
+#include "db-copy.hpp"
+#include "logging.hpp"
+#include "middle.hpp"
+#include "output.hpp"
+
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cassert>
+#include <exception>
+#include <utility>
+
+namespace {
+
+/// Batches are handed to the workers when they reach this size in bytes.
+constexpr std::size_t MAX_BATCH_SIZE = 1024UL * 1024UL;
+
+/// Maximum number of batches waiting in the queue for each worker.
+constexpr std::size_t MAX_QUEUE_SIZE_PER_WORKER = 2;
+
+osmium::memory::Buffer new_batch()
+{
+    return osmium::memory::Buffer{MAX_BATCH_SIZE + (MAX_BATCH_SIZE / 4),
+                                  osmium::memory::Buffer::auto_grow::yes};
+}
+
+} // anonymous namespace
+
+parallel_import_t::parallel_import_t(
+    connection_params_t const &connection_params,
+    std::shared_ptr<middle_t> const &mid, std::shared_ptr<output_t> output,
+    std::size_t thread_count)
+: m_output(std::move(output)), m_batch(new_batch())
+{
+    assert(mid);
+    assert(m_output);
+
+    // For each thread we create a clone of the output.
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        auto const midq = mid->get_query_instance();
+        auto copy_thread =
+            std::make_shared<db_copy_thread_t>(connection_params);
+        m_clones.push_back(m_output->clone(midq, copy_thread));
+    }
+}
+
+parallel_import_t::~parallel_import_t() noexcept
+{
+    if (m_workers.empty()) {
+        return;
+    }
+
+    // We only get here if something went wrong in the input thread. Tell
+    // the workers to stop and ignore any errors they might have.
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_queue.clear();
+        m_done = true;
+    }
+    m_queue_changed.notify_all();
+
+    for (auto &worker : m_workers) {
+        try {
+            worker.get();
+        } catch (...) { // NOLINT(bugprone-empty-catch)
+        }
+    }
+}
+
+void parallel_import_t::start_workers()
+{
+    log_debug("Starting {} threads for processing objects.", m_clones.size());
+
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_done = false;
+    }
+
+    m_workers.reserve(m_clones.size());
+    for (auto const &clone : m_clones) {
+        m_workers.push_back(std::async(std::launch::async,
+                                       [this, &clone]() { run(clone.get()); }));
+    }
+}
+
+void parallel_import_t::add(osmium::OSMObject const &object)
+{
+    assert(object.type() == osmium::item_type::way ||
+           object.type() == osmium::item_type::relation);
+
+    if (m_workers.empty()) {
+        start_workers();
+    }
+
+    m_batch.add_item(object);
+    m_batch.commit();
+
+    if (m_batch.committed() >= MAX_BATCH_SIZE) {
+        push_batch();
+    }
+}
+
+void parallel_import_t::push_batch()
+{
+    bool failed = false;
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_queue_changed.wait(lock, [&]() {
+            return m_failed ||
+                   m_queue.size() < m_clones.size() * MAX_QUEUE_SIZE_PER_WORKER;
+        });
+
+        failed = m_failed;
+        if (!failed) {
+            m_queue.push_back(std::move(m_batch));
+        }
+    }
+    m_queue_changed.notify_all();
+
+    m_batch = new_batch();
+
+    if (failed) {
+        // This will rethrow the exception from the worker.
+        finish();
+    }
+}
+
+bool parallel_import_t::pop_batch(osmium::memory::Buffer *batch)
+{
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_queue_changed.wait(lock,
+                             [&]() { return m_done || !m_queue.empty(); });
+
+        if (m_queue.empty()) {
+            return false;
+        }
+
+        *batch = std::move(m_queue.front());
+        m_queue.pop_front();
+    }
+    m_queue_changed.notify_all();
+
+    return true;
+}
+
+void parallel_import_t::run(output_t *output)
+{
+    try {
+        osmium::memory::Buffer batch{};
+        while (pop_batch(&batch)) {
+            for (auto &object : batch.select<osmium::OSMObject>()) {
+                if (object.type() == osmium::item_type::way) {
+                    output->way_add(static_cast<osmium::Way *>(&object));
+                } else {
+                    output->relation_add(
+                        static_cast<osmium::Relation const &>(object));
+                }
+            }
+        }
+        output->sync();
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> const lock{m_mutex};
+            m_failed = true;
+            m_done = true;
+            m_queue.clear();
+        }
+        m_queue_changed.notify_all();
+        throw;
+    }
+}
+
+void parallel_import_t::finish()
+{
+    if (m_workers.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        if (m_batch.committed() > 0 && !m_failed) {
+            m_queue.push_back(std::move(m_batch));
+        }
+        m_done = true;
+    }
+    m_batch = new_batch();
+    m_queue_changed.notify_all();
+
+    auto workers = std::move(m_workers);
+    m_workers.clear();
+
+    std::exception_ptr eptr;
+    for (auto &worker : workers) {
+        try {
+            worker.get();
+        } catch (...) {
+            if (!eptr) {
+                eptr = std::current_exception();
+            }
+        }
+    }
+
+    if (eptr) {
+        std::rethrow_exception(eptr);
+    }
+}
+
+void parallel_import_t::merge_expire_trees()
+{
+    for (auto const &clone : m_clones) {
+        m_output->merge_expire_trees(clone.get());
+    }
+}
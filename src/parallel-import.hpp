@@ -0,0 +1,110 @@
+#ifndef OSM2PGSQL_PARALLEL_IMPORT_HPP
+#define OSM2PGSQL_PARALLEL_IMPORT_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "pgsql-params.hpp"
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class middle_t;
+class output_t;
+
+/**
+ * Hands ways and relations read from the input to clones of the output
+ * running in their own threads during an import. This way building the
+ * geometries, which is the most expensive part of the processing, is
+ * spread over several CPUs.
+ *
+ * Objects are copied into batches and the batches are put into a queue
+ * from which the worker threads take them. The queue has a maximum size,
+ * so if the workers can't keep up, the input thread has to wait.
+ *
+ * The middle must not change the data the outputs read while the workers
+ * are running: During the way phase the outputs only read node locations
+ * which are complete at that point. During the relation phase they read
+ * member ways, so this can only be used for relations if the middle can
+ * read ways while relations are added.
+ */
+class parallel_import_t
+{
+public:
+    parallel_import_t(connection_params_t const &connection_params,
+                      std::shared_ptr<middle_t> const &mid,
+                      std::shared_ptr<output_t> output,
+                      std::size_t thread_count);
+
+    parallel_import_t(parallel_import_t const &) = delete;
+    parallel_import_t &operator=(parallel_import_t const &) = delete;
+
+    parallel_import_t(parallel_import_t &&) = delete;
+    parallel_import_t &operator=(parallel_import_t &&) = delete;
+
+    ~parallel_import_t() noexcept;
+
+    /**
+     * Add a way or relation for processing. The worker threads are started
+     * when the first object is added after construction or finish().
+     */
+    void add(osmium::OSMObject const &object);
+
+    /**
+     * Wait until all objects added so far are processed and stop the
+     * worker threads. Rethrows any exception from the worker threads.
+     */
+    void finish();
+
+    /**
+     * Merge expiry tree information from all clones back into the original
+     * output.
+     */
+    void merge_expire_trees();
+
+private:
+    void start_workers();
+    void push_batch();
+    bool pop_batch(osmium::memory::Buffer *batch);
+    void run(output_t *output);
+
+    /// Clones of output, one clone per thread.
+    std::vector<std::shared_ptr<output_t>> m_clones;
+
+    /// The output.
+    std::shared_ptr<output_t> m_output;
+
+    std::vector<std::future<void>> m_workers;
+
+    /// The batch currently being filled by the input thread.
+    osmium::memory::Buffer m_batch;
+
+    /// Batches waiting to be processed, protected by m_mutex.
+    std::deque<osmium::memory::Buffer> m_queue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_queue_changed;
+
+    /// No more batches will be added to the queue, protected by m_mutex.
+    bool m_done = false;
+
+    /// One of the workers failed, protected by m_mutex.
+    bool m_failed = false;
+
+}; // class parallel_import_t
+
+#endif // OSM2PGSQL_PARALLEL_IMPORT_HPP
@@ -0,0 +1,192 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "postprocessing-progress.hpp"
+
+#include "logging.hpp"
+#include "pgsql-capabilities.hpp"
+#include "pgsql.hpp"
+#include "util.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+
+namespace {
+
+// pg_stat_progress_create_index is available from PostgreSQL 12 on.
+constexpr uint32_t const MIN_VERSION_PROGRESS_CREATE_INDEX = 120000;
+
+std::string build_query()
+{
+    std::string sql =
+        "SELECT a.pid, a.application_name,"
+        " extract(epoch FROM now() - a.query_start)::bigint,"
+        " left(regexp_replace(a.query, '\\s+', ' ', 'g'), 80),";
+
+    if (get_database_version() >= MIN_VERSION_PROGRESS_CREATE_INDEX) {
+        sql += " p.phase, p.blocks_total, p.blocks_done,"
+               " p.tuples_total, p.tuples_done"
+               " FROM pg_stat_activity a"
+               " LEFT JOIN pg_stat_progress_create_index p"
+               " ON p.pid = a.pid";
+    } else {
+        sql += " NULL, NULL, NULL, NULL, NULL FROM pg_stat_activity a";
+    }
+
+    sql += " WHERE a.application_name LIKE 'osm2pgsql.%'"
+           " AND a.state = 'active'"
+           " AND a.pid <> pg_backend_pid()"
+           " AND a.datname = current_database()"
+           " ORDER BY a.query_start";
+
+    return sql;
+}
+
+double progress_fraction(pg_result_t const &result, int row)
+{
+    for (int col : {5, 7}) {
+        if (!result.is_null(row, col) && !result.is_null(row, col + 1)) {
+            auto const total = std::strtod(result.get_value(row, col), nullptr);
+            if (total > 0) {
+                return std::strtod(result.get_value(row, col + 1), nullptr) /
+                       total;
+            }
+        }
+    }
+    return -1.0;
+}
+
+} // anonymous namespace
+
+double estimate_seconds_left(double first_fraction, double fraction,
+                             double elapsed) noexcept
+{
+    if (fraction <= first_fraction || elapsed <= 0.0) {
+        return -1.0;
+    }
+
+    auto const rate = (fraction - first_fraction) / elapsed;
+    return (1.0 - fraction) / rate;
+}
+
+postprocessing_progress_t::postprocessing_progress_t(
+    connection_params_t connection_params, std::chrono::seconds interval)
+: m_connection_params(std::move(connection_params)), m_interval(interval),
+  m_thread([this] { run(); })
+{}
+
+postprocessing_progress_t::~postprocessing_progress_t() noexcept { stop(); }
+
+void postprocessing_progress_t::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> const guard{m_mutex};
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void postprocessing_progress_t::run()
+{
+    try {
+        pg_conn_t const db_connection{m_connection_params, "progress"};
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+        while (!m_cv.wait_for(lock, m_interval, [this] { return m_stop; })) {
+            lock.unlock();
+            report(db_connection);
+            lock.lock();
+        }
+    } catch (std::exception const &e) {
+        log_warn("Can not report postprocessing progress: {}", e.what());
+    } catch (...) {
+        log_warn("Can not report postprocessing progress.");
+    }
+}
+
+void postprocessing_progress_t::report(pg_conn_t const &db_connection)
+{
+    auto const messages = collect(db_connection);
+    if (messages.empty()) {
+        return;
+    }
+
+    log_info("Postprocessing still running:");
+    for (auto const &msg : messages) {
+        log_info("  {}", msg);
+    }
+}
+
+std::vector<std::string>
+postprocessing_progress_t::collect(pg_conn_t const &db_connection)
+{
+    auto const result = db_connection.exec(build_query());
+    auto const now = std::chrono::steady_clock::now();
+
+    // Work on a copy of the previous observations, so the mutex doesn't
+    // have to be held while building the messages.
+    decltype(m_observations) previous;
+    {
+        std::lock_guard<std::mutex> const guard{m_mutex};
+        previous = m_observations;
+    }
+    decltype(m_observations) observations;
+
+    std::vector<std::string> messages;
+    for (int row = 0; row < result.num_tuples(); ++row) {
+        std::string const pid{result.get(row, 0)};
+        auto const seconds =
+            std::strtoull(result.get_value(row, 2), nullptr, 10);
+
+        std::string msg = fmt::format(
+            "{} for {}: {}", result.get(row, 1),
+            util::human_readable_duration(seconds), result.get(row, 3));
+
+        if (!result.is_null(row, 4)) {
+            std::string const phase{result.get(row, 4)};
+            msg += fmt::format(" [{}", phase);
+
+            auto const fraction = progress_fraction(result, row);
+            if (fraction >= 0.0) {
+                msg += fmt::format(" {:.1f}%", fraction * 100.0);
+
+                auto key = std::make_pair(pid, phase);
+                auto const it = previous.find(key);
+                observation_t const first = it == previous.end()
+                                                ? observation_t{now, fraction}
+                                                : it->second;
+                observations.emplace(std::move(key), first);
+
+                std::chrono::duration<double> const elapsed = now - first.time;
+                auto const left = estimate_seconds_left(
+                    first.fraction, fraction, elapsed.count());
+                if (left >= 0.0) {
+                    msg += fmt::format(", about {} left",
+                                       util::human_readable_duration(
+                                           static_cast<uint64_t>(left)));
+                }
+            }
+            msg += ']';
+        }
+
+        messages.push_back(std::move(msg));
+    }
+
+    {
+        std::lock_guard<std::mutex> const guard{m_mutex};
+        m_observations = std::move(observations);
+    }
+
+    return messages;
+}
@@ -0,0 +1,103 @@
+#ifndef OSM2PGSQL_POSTPROCESSING_PROGRESS_HPP
+#define OSM2PGSQL_POSTPROCESSING_PROGRESS_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "pgsql-params.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class pg_conn_t;
+
+/**
+ * Reports progress of the post-processing (clustering, index creation)
+ * running in the database from other connections.
+ *
+ * A background thread regularly looks at pg_stat_activity for osm2pgsql
+ * connections with active queries. On PostgreSQL 12 and above the index
+ * builds are joined with pg_stat_progress_create_index to show how far they
+ * are along and an estimate for how long they will still take.
+ */
+class postprocessing_progress_t
+{
+public:
+    static constexpr std::chrono::seconds DEFAULT_INTERVAL{30};
+
+    explicit postprocessing_progress_t(
+        connection_params_t connection_params,
+        std::chrono::seconds interval = DEFAULT_INTERVAL);
+
+    postprocessing_progress_t(postprocessing_progress_t const &) = delete;
+    postprocessing_progress_t &
+    operator=(postprocessing_progress_t const &) = delete;
+
+    postprocessing_progress_t(postprocessing_progress_t &&) = delete;
+    postprocessing_progress_t &operator=(postprocessing_progress_t &&) = delete;
+
+    ~postprocessing_progress_t() noexcept;
+
+    /// Stop reporting progress. Called automatically from the destructor.
+    void stop() noexcept;
+
+    /**
+     * Get a message for each osm2pgsql connection with an active query.
+     * This is what is logged regularly from the background thread. Can be
+     * called from any thread, access to the observations from earlier calls
+     * is protected by the mutex.
+     */
+    std::vector<std::string> collect(pg_conn_t const &db_connection);
+
+private:
+    void run();
+
+    void report(pg_conn_t const &db_connection);
+
+    connection_params_t m_connection_params;
+    std::chrono::seconds m_interval;
+
+    /**
+     * Remember when we first saw each backend in a certain phase and how
+     * far along it was, so we can estimate the time left.
+     */
+    struct observation_t
+    {
+        std::chrono::steady_clock::time_point time;
+        double fraction = 0.0;
+    };
+    std::map<std::pair<std::string, std::string>, observation_t>
+        m_observations;
+
+    /// Protects m_observations and m_stop.
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+
+    std::thread m_thread;
+
+}; // class postprocessing_progress_t
+
+/**
+ * Estimate the time left for a task that was at first_fraction (0.0 - 1.0)
+ * of its work and is now at fraction after elapsed seconds.
+ *
+ * \returns Number of seconds left or -1 if there is no estimate because
+ *          there was no progress.
+ */
+double estimate_seconds_left(double first_fraction, double fraction,
+                             double elapsed) noexcept;
+
+#endif // OSM2PGSQL_POSTPROCESSING_PROGRESS_HPP
@@ -0,0 +1,94 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "relation-lru-cache.hpp"
+
+#include <utility>
+
+namespace {
+
+osmium::memory::Buffer copy_buffer(osmium::memory::Buffer const &buffer)
+{
+    osmium::memory::Buffer copy{buffer.committed(),
+                                osmium::memory::Buffer::auto_grow::no};
+    copy.add_buffer(buffer);
+    copy.commit();
+    return copy;
+}
+
+} // anonymous namespace
+
+void relation_lru_cache_t::add(osmid_t id,
+                               osmium::memory::Buffer const &relation,
+                               osmium::memory::Buffer const &members)
+{
+    entry_t entry{id, copy_buffer(relation), copy_buffer(members)};
+    auto const bytes = entry_bytes(entry);
+    if (bytes > m_max_bytes) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> const lock{m_mutex};
+
+    if (m_index.count(id) > 0) {
+        return;
+    }
+
+    while (!m_entries.empty() && m_bytes + bytes > m_max_bytes) {
+        auto const &last = m_entries.back();
+        m_bytes -= entry_bytes(last);
+        m_index.erase(last.id);
+        m_entries.pop_back();
+    }
+
+    m_entries.push_front(std::move(entry));
+    m_index.emplace(id, m_entries.begin());
+    m_bytes += bytes;
+}
+
+bool relation_lru_cache_t::get(osmid_t id, osmium::memory::Buffer *relation,
+                               osmium::memory::Buffer *members)
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+
+    auto const it = m_index.find(id);
+    if (it == m_index.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+    auto const &entry = m_entries.front();
+    relation->add_buffer(entry.relation);
+    relation->commit();
+    members->add_buffer(entry.members);
+    members->commit();
+
+    return true;
+}
+
+std::size_t relation_lru_cache_t::size() const
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    return m_entries.size();
+}
+
+std::size_t relation_lru_cache_t::hits() const
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    return m_hits;
+}
+
+std::size_t relation_lru_cache_t::misses() const
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    return m_misses;
+}
@@ -0,0 +1,90 @@
+#ifndef OSM2PGSQL_RELATION_LRU_CACHE_HPP
+#define OSM2PGSQL_RELATION_LRU_CACHE_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "osmtypes.hpp"
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * Cache for relations together with their members as fetched from the
+ * middle. In append mode the same relation is often processed more than
+ * once (in stage 1b and 1c), this avoids getting it and all its members
+ * from the middle again.
+ *
+ * The cache holds copies of the buffers, it has a maximum size in bytes
+ * and throws out the least recently used relations when it is full.
+ *
+ * This can be used from several threads at the same time. It must only be
+ * used while the middle doesn't change, otherwise the cached data might be
+ * outdated.
+ */
+class relation_lru_cache_t
+{
+public:
+    explicit relation_lru_cache_t(std::size_t max_bytes) noexcept
+    : m_max_bytes(max_bytes)
+    {}
+
+    /**
+     * Add a copy of the relation and member buffers to the cache. If the
+     * relation is already in the cache, nothing happens.
+     */
+    void add(osmid_t id, osmium::memory::Buffer const &relation,
+             osmium::memory::Buffer const &members);
+
+    /**
+     * Look up relation in the cache. If it is found, the cached relation
+     * and members are added to the buffers.
+     *
+     * \returns True if the relation was found, false otherwise.
+     */
+    bool get(osmid_t id, osmium::memory::Buffer *relation,
+             osmium::memory::Buffer *members);
+
+    std::size_t size() const;
+
+    std::size_t hits() const;
+
+    std::size_t misses() const;
+
+private:
+    struct entry_t
+    {
+        osmid_t id;
+        osmium::memory::Buffer relation;
+        osmium::memory::Buffer members;
+    };
+
+    static std::size_t entry_bytes(entry_t const &entry) noexcept
+    {
+        return entry.relation.capacity() + entry.members.capacity();
+    }
+
+    // Most recently used entry at the front.
+    std::list<entry_t> m_entries;
+    std::unordered_map<osmid_t, std::list<entry_t>::iterator> m_index;
+
+    std::size_t m_max_bytes;
+    std::size_t m_bytes = 0;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+
+    mutable std::mutex m_mutex;
+
+}; // class relation_lru_cache_t
+
+#endif // OSM2PGSQL_RELATION_LRU_CACHE_HPP
@@ -6,6 +6,8 @@
 
 #include <proj.h>
 
+#include <type_traits>
+
 namespace {
 
 /**
@@ -25,6 +27,27 @@ public:
         return transform(m_transformation.get(), point);
     }
 
+    void reproject_points(geom::point_t *points,
+                          std::size_t count) const noexcept override
+    {
+        static_assert(std::is_standard_layout_v<geom::point_t> &&
+                          sizeof(geom::point_t) == 2 * sizeof(double),
+                      "point_t must consist of exactly two doubles");
+
+        if (count == 0) {
+            return;
+        }
+
+        // Transform the x and y coordinates of the points in place in one
+        // call. Missing z and t coordinates are set to the same defaults
+        // as in transform() by proj.
+        auto *const coords = reinterpret_cast<double *>(points);
+        proj_trans_generic(m_transformation.get(), PJ_FWD, coords,
+                           sizeof(geom::point_t), count, coords + 1,
+                           sizeof(geom::point_t), count, nullptr, 0, 0,
+                           nullptr, 0, 0);
+    }
+
     geom::point_t target_to_tile(geom::point_t point) const override
     {
         return transform(m_transformation_tile.get(), point);
@@ -12,22 +12,108 @@
 #include "format.hpp"
 #include "reprojection.hpp"
 
+#include <algorithm>
+#include <array>
+
 namespace {
 
+constexpr double const MAX_MERC_LAT = 89.99;
+
 geom::point_t lonlat2merc(geom::point_t point)
 {
     osmium::geom::Coordinates coords{point.x(), point.y()};
 
-    if (coords.y > 89.99) {
-        coords.y = 89.99;
-    } else if (coords.y < -89.99) {
-        coords.y = -89.99;
+    if (coords.y > MAX_MERC_LAT) {
+        coords.y = MAX_MERC_LAT;
+    } else if (coords.y < -MAX_MERC_LAT) {
+        coords.y = -MAX_MERC_LAT;
     }
 
     auto c = osmium::geom::lonlat_to_mercator(coords);
     return {c.x, c.y};
 }
 
+#ifndef OSMIUM_USE_SLOW_MERCATOR_PROJECTION
+/**
+ * This is the same rational approximation libosmium uses in
+ * osmium::geom::detail::lat_to_y() for latitudes between -78 and 78 degrees,
+ * but without the branch for other latitudes, so that the compiler can
+ * vectorize loops calling it.
+ */
+double lat_to_y_approx(double lat) noexcept
+{
+    return osmium::geom::detail::earth_radius_for_epsg3857 *
+           ((((((((((-3.1112583378460085319e-23 * lat +
+                     2.0465852743943268009e-19) * lat +
+                    6.4905282018672673884e-18) * lat +
+                   -1.9685447939983315591e-14) * lat +
+                  -2.2022588158115104182e-13) * lat +
+                 5.1617537365509453239e-10) * lat +
+                2.5380136069803016519e-9) * lat +
+               -5.1448323697228488745e-6) * lat +
+              -9.4888671473357768301e-6) * lat +
+             1.7453292518154191887e-2) * lat) /
+           ((((((((((-1.9741136066814230637e-22 * lat +
+                     -1.258514031244679556e-20) * lat +
+                    4.8141483273572351796e-17) * lat +
+                   8.6876090870176172185e-16) * lat +
+                  -2.3298743439377541768e-12) * lat +
+                 -1.9300094785736130185e-11) * lat +
+                4.3251609106864178231e-8) * lat +
+               1.7301944508516974048e-7) * lat +
+              -3.4554675198786337842e-4) * lat +
+             -5.4367203601085991108e-4) * lat + 1.0);
+}
+
+/**
+ * Batch version of lonlat2merc(). Points are handled in blocks: First the
+ * approximation is calculated for all points in a block in a tight loop
+ * without branches the compiler can vectorize, then the few points outside
+ * the range of the approximation are fixed up using the exact formula.
+ */
+void lonlat2merc_points(geom::point_t *points, std::size_t count) noexcept
+{
+    constexpr std::size_t const BLOCK_SIZE = 64;
+    constexpr double const MAX_APPROX_LAT = 78.0;
+
+    std::array<double, BLOCK_SIZE> lats{};
+
+    while (count > 0) {
+        auto const num = std::min(count, BLOCK_SIZE);
+
+        for (std::size_t i = 0; i < num; ++i) {
+            lats[i] = points[i].y();
+        }
+
+        // No clamping here, comparisons would keep the compiler from
+        // vectorizing the loop. Results for latitudes outside the range
+        // of the approximation are garbage, but they are replaced below.
+        for (std::size_t i = 0; i < num; ++i) {
+            points[i].set_x(osmium::geom::detail::lon_to_x(points[i].x()));
+            points[i].set_y(lat_to_y_approx(lats[i]));
+        }
+
+        for (std::size_t i = 0; i < num; ++i) {
+            if (lats[i] < -MAX_APPROX_LAT || lats[i] > MAX_APPROX_LAT) {
+                auto const lat =
+                    std::clamp(lats[i], -MAX_MERC_LAT, MAX_MERC_LAT);
+                points[i].set_y(osmium::geom::detail::lat_to_y_with_tan(lat));
+            }
+        }
+
+        points += num;
+        count -= num;
+    }
+}
+#else
+void lonlat2merc_points(geom::point_t *points, std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        points[i] = lonlat2merc(points[i]);
+    }
+}
+#endif
+
 class latlon_reprojection_t : public reprojection_t
 {
 public:
@@ -36,6 +122,10 @@ public:
         return point;
     }
 
+    void reproject_points(geom::point_t * /*points*/,
+                          std::size_t /*count*/) const noexcept override
+    {}
+
     geom::point_t target_to_tile(geom::point_t point) const noexcept override
     {
         return lonlat2merc(point);
@@ -54,6 +144,12 @@ public:
         return lonlat2merc(coords);
     }
 
+    void reproject_points(geom::point_t *points,
+                          std::size_t count) const noexcept override
+    {
+        lonlat2merc_points(points, count);
+    }
+
     geom::point_t target_to_tile(geom::point_t c) const noexcept override
     {
         return c;
@@ -69,6 +165,14 @@ public:
 
 } // anonymous namespace
 
+void reprojection_t::reproject_points(geom::point_t *points,
+                                      std::size_t count) const
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        points[i] = reproject(points[i]);
+    }
+}
+
 std::shared_ptr<reprojection_t> reprojection_t::create_projection(int srs)
 {
     switch (srs) {
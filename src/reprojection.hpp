@@ -19,6 +19,7 @@
 #include "geom.hpp"
 #include "projection.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -47,6 +48,15 @@ public:
      */
     virtual geom::point_t reproject(geom::point_t point) const = 0;
 
+    /**
+     * Reproject all points in the array from the source projection lat/lon
+     * (EPSG:4326) to the target projection in place. The result is the same
+     * as calling reproject() on each point, but implementations can do this
+     * much faster than one virtual call per point.
+     */
+    virtual void reproject_points(geom::point_t *points,
+                                  std::size_t count) const;
+
     /**
      * Converts coordinates from target projection to tile projection
      * (EPSG:3857)
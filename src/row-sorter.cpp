@@ -0,0 +1,189 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "row-sorter.hpp"
+
+#include "logging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <queue>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+void write_or_throw(void const *data, std::size_t size, std::FILE *file)
+{
+    if (std::fwrite(data, 1, size, file) != size) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Writing to temporary sort file failed"};
+    }
+}
+
+void read_or_throw(void *data, std::size_t size, std::FILE *file)
+{
+    if (std::fread(data, 1, size, file) != size) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Reading from temporary sort file failed"};
+    }
+}
+
+/**
+ * Reads the rows of one sorted run back from a temporary file. The file
+ * contains for each row the key, the length of the row and the row data.
+ */
+class run_reader_t
+{
+public:
+    explicit run_reader_t(std::FILE *file) : m_file(file)
+    {
+        std::rewind(m_file);
+    }
+
+    /// Read next row. Returns false if there are no more rows.
+    bool next()
+    {
+        uint64_t key = 0;
+        if (std::fread(&key, sizeof(key), 1, m_file) != 1) {
+            return false;
+        }
+        m_key = quadkey_t{key};
+
+        uint64_t length = 0;
+        read_or_throw(&length, sizeof(length), m_file);
+        m_row.resize(length);
+        read_or_throw(m_row.data(), length, m_file);
+
+        return true;
+    }
+
+    quadkey_t key() const noexcept { return m_key; }
+
+    std::string const &row() const noexcept { return m_row; }
+
+private:
+    std::FILE *m_file;
+    std::string m_row;
+    quadkey_t m_key;
+}; // class run_reader_t
+
+} // anonymous namespace
+
+void row_sorter_t::add(quadkey_t key, std::string_view row)
+{
+    m_entries.push_back({key, m_data.size(), row.size()});
+    m_data.append(row);
+    ++m_count;
+
+    if (m_data.size() + m_entries.size() * sizeof(entry_t) >= m_max_memory) {
+        spill();
+    }
+}
+
+void row_sorter_t::sort_entries()
+{
+    std::stable_sort(m_entries.begin(), m_entries.end(),
+                     [](entry_t const &a, entry_t const &b) noexcept {
+                         return a.key < b.key;
+                     });
+}
+
+void row_sorter_t::spill()
+{
+    if (m_entries.empty()) {
+        return;
+    }
+
+    sort_entries();
+
+    file_ptr_t file{std::tmpfile()};
+    if (!file) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Could not create temporary sort file"};
+    }
+
+    for (auto const &entry : m_entries) {
+        uint64_t const key = entry.key.value();
+        uint64_t const length = entry.length;
+        write_or_throw(&key, sizeof(key), file.get());
+        write_or_throw(&length, sizeof(length), file.get());
+        write_or_throw(m_data.data() + entry.offset, entry.length, file.get());
+    }
+
+    if (std::fflush(file.get()) != 0) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Writing to temporary sort file failed"};
+    }
+
+    log_debug("Wrote sorted run with {} rows to temporary file.",
+              m_entries.size());
+
+    m_runs.push_back(std::move(file));
+    m_entries.clear();
+    m_data.clear();
+}
+
+void row_sorter_t::merge_runs(
+    std::function<void(quadkey_t, std::string_view)> const &func)
+{
+    std::vector<run_reader_t> readers;
+    readers.reserve(m_runs.size());
+
+    // The queue contains the index of all readers that still have rows,
+    // ordered by the key of their current row. For the same key the earlier
+    // run comes first, so that rows with the same key stay in order.
+    auto const cmp = [&readers](std::size_t a, std::size_t b) noexcept {
+        if (readers[a].key() == readers[b].key()) {
+            return a > b;
+        }
+        return readers[b].key() < readers[a].key();
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(cmp)>
+        queue{cmp};
+
+    for (auto const &run : m_runs) {
+        readers.emplace_back(run.get());
+    }
+
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        if (readers[i].next()) {
+            queue.push(i);
+        }
+    }
+
+    while (!queue.empty()) {
+        auto const i = queue.top();
+        queue.pop();
+        func(readers[i].key(), readers[i].row());
+        if (readers[i].next()) {
+            queue.push(i);
+        }
+    }
+}
+
+void row_sorter_t::drain(
+    std::function<void(quadkey_t, std::string_view)> const &func)
+{
+    if (m_runs.empty()) {
+        sort_entries();
+        for (auto const &entry : m_entries) {
+            func(entry.key,
+                 std::string_view{m_data.data() + entry.offset, entry.length});
+        }
+    } else {
+        spill();
+        merge_runs(func);
+    }
+
+    m_runs.clear();
+    m_entries = std::vector<entry_t>{};
+    m_data = std::string{};
+    m_count = 0;
+}
@@ -0,0 +1,100 @@
+#ifndef OSM2PGSQL_ROW_SORTER_HPP
+#define OSM2PGSQL_ROW_SORTER_HPP
+
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include "tile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Collects rows (strings in COPY format) with a sort key and returns them
+ * sorted by that key. Rows with the same key are returned in the order they
+ * were added.
+ *
+ * Rows are kept in memory until the configured amount of memory is used.
+ * Then they are sorted and written out to a temporary file as a sorted
+ * "run". When reading back the rows, all runs are merged.
+ */
+class row_sorter_t
+{
+public:
+    /// Default for the amount of memory used for row data before spilling.
+    static constexpr std::size_t DEFAULT_MAX_MEMORY = 256UL * 1024UL * 1024UL;
+
+    explicit row_sorter_t(std::size_t max_memory = DEFAULT_MAX_MEMORY)
+    : m_max_memory(max_memory)
+    {}
+
+    /// Add a row with the specified sort key.
+    void add(quadkey_t key, std::string_view row);
+
+    /// The number of rows added (and not yet read back).
+    std::size_t size() const noexcept { return m_count; }
+
+    bool empty() const noexcept { return m_count == 0; }
+
+    /// The number of sorted runs written out to temporary files.
+    std::size_t num_runs() const noexcept { return m_runs.size(); }
+
+    /**
+     * Call the function with key and row data for all rows in the order of
+     * their sort keys. Afterwards the sorter is empty and can be used again.
+     */
+    void drain(std::function<void(quadkey_t, std::string_view)> const &func);
+
+private:
+    struct entry_t
+    {
+        quadkey_t key;
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    struct file_closer_t
+    {
+        void operator()(std::FILE *file) const noexcept { std::fclose(file); }
+    };
+
+    using file_ptr_t = std::unique_ptr<std::FILE, file_closer_t>;
+
+    /// Sort the rows in memory.
+    void sort_entries();
+
+    /// Write all rows in memory to a new temporary file as a sorted run.
+    void spill();
+
+    /// Merge all runs in temporary files.
+    void
+    merge_runs(std::function<void(quadkey_t, std::string_view)> const &func);
+
+    /// Row data of all rows in memory.
+    std::string m_data;
+
+    /// Keys and positions in m_data of all rows in memory.
+    std::vector<entry_t> m_entries;
+
+    /// Temporary files with sorted runs.
+    std::vector<file_ptr_t> m_runs;
+
+    std::size_t m_max_memory;
+
+    std::size_t m_count = 0;
+
+}; // class row_sorter_t
+
+#endif // OSM2PGSQL_ROW_SORTER_HPP
@@ -15,6 +15,9 @@
 
 #include <osmium/index/nwr_array.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -65,6 +68,78 @@ private:
     osmium::nwr_array<std::vector<taginfo>> m_export_list;
 };
 
+/**
+ * Lookup structure for the keys in the export list of one object type.
+ * It gives the same results as going through the list entry by entry and
+ * stopping at the first delete entry matching the key or the first normal
+ * entry with exactly that name.
+ *
+ * All keys without wildcards are put into a perfect hash table which is
+ * built once when the index is created, so a lookup only needs to hash
+ * the key once and compare it to a single entry. Only the delete entries
+ * with wildcards need to be checked one by one, and only those that come
+ * before the matching normal entry in the list.
+ */
+class export_key_index_t
+{
+public:
+    enum class result : uint8_t
+    {
+        unknown, // key not in export list
+        keep,    // key has a normal entry in the export list
+        drop     // key matches a delete entry in the export list
+    };
+
+    export_key_index_t() : m_displacements(1, 0), m_table(1, 0) {}
+
+    explicit export_key_index_t(std::vector<taginfo> const &infos);
+
+    /**
+     * Look up the key. If the result is "keep", the flags of the entry are
+     * or'ed into flags.
+     */
+    result find(char const *key, unsigned int *flags) const noexcept;
+
+private:
+    static constexpr std::size_t NOT_FOUND =
+        std::numeric_limits<std::size_t>::max();
+
+    struct entry_t
+    {
+        std::string key;
+        unsigned int flags = 0;
+
+        // Positions of the first normal and the first delete entry with
+        // this key in the export list.
+        std::size_t keep_pos = NOT_FOUND;
+        std::size_t delete_pos = NOT_FOUND;
+    };
+
+    struct wildcard_t
+    {
+        std::string pattern;
+        std::size_t pos;
+    };
+
+    static uint64_t hash(char const *str, std::size_t len) noexcept;
+
+    std::size_t slot(uint64_t hash_value) const noexcept;
+
+    void build_table();
+
+    std::vector<entry_t> m_entries;
+
+    // Delete entries with wildcards in the order of the export list.
+    std::vector<wildcard_t> m_wildcards;
+
+    // Displacement value for each bucket.
+    std::vector<uint32_t> m_displacements;
+
+    // For each slot the index into m_entries plus 1, 0 for empty slots.
+    std::vector<uint32_t> m_table;
+
+}; // class export_key_index_t
+
 /* Parse a comma or whitespace delimited list of tags to apply to
  * a style file entry, returning the OR-ed set of flags.
  */
@@ -10,12 +10,15 @@
 #include "format.hpp"
 #include "logging.hpp"
 #include "taginfo-impl.hpp"
+#include "wildcmp.hpp"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <map>
 #include <stdexcept>
 #include <system_error>
+#include <unordered_map>
 
 #include <osmium/util/string.hpp>
 
@@ -43,6 +46,182 @@ columns_t export_list_t::normal_columns(osmium::item_type type) const
     return columns;
 }
 
+export_key_index_t::export_key_index_t(std::vector<taginfo> const &infos)
+{
+    std::unordered_map<std::string, std::size_t> entry_index;
+
+    for (std::size_t pos = 0; pos < infos.size(); ++pos) {
+        auto const &info = infos[pos];
+        bool const is_delete = info.flags & FLAG_DELETE;
+
+        if (is_delete &&
+            info.name.find_first_of("*?") != std::string::npos) {
+            m_wildcards.push_back({info.name, pos});
+            continue;
+        }
+
+        auto const [it, inserted] =
+            entry_index.emplace(info.name, m_entries.size());
+        if (inserted) {
+            m_entries.emplace_back();
+            m_entries.back().key = info.name;
+        }
+
+        auto &entry = m_entries[it->second];
+        if (is_delete) {
+            if (entry.delete_pos == NOT_FOUND) {
+                entry.delete_pos = pos;
+            }
+        } else if (entry.keep_pos == NOT_FOUND) {
+            entry.keep_pos = pos;
+            entry.flags = info.flags;
+        }
+    }
+
+    build_table();
+}
+
+uint64_t export_key_index_t::hash(char const *str, std::size_t len) noexcept
+{
+    // FNV-1a
+    uint64_t value = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < len; ++i) {
+        value ^= static_cast<unsigned char>(str[i]);
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+std::size_t export_key_index_t::slot(uint64_t hash_value) const noexcept
+{
+    auto const bucket = (hash_value >> 32U) % m_displacements.size();
+    auto const displacement = m_displacements[bucket];
+    auto const step = static_cast<uint32_t>(hash_value >> 16U) | 1U;
+    return (static_cast<uint32_t>(hash_value) + displacement * step) &
+           (m_table.size() - 1);
+}
+
+/**
+ * Build the perfect hash table using the "hash and displace" method: The
+ * keys are grouped into buckets and, starting with the largest bucket, a
+ * displacement value is searched for each bucket which puts all its keys
+ * into slots that are still free.
+ */
+void export_key_index_t::build_table()
+{
+    constexpr uint32_t MAX_DISPLACEMENT = 1U << 16U;
+    constexpr std::size_t MAX_TABLE_SIZE = 1U << 24U;
+
+    std::vector<uint64_t> hashes;
+    hashes.reserve(m_entries.size());
+    for (auto const &entry : m_entries) {
+        hashes.push_back(hash(entry.key.data(), entry.key.size()));
+    }
+
+    std::size_t table_size = 1;
+    while (table_size < m_entries.size() * 2) {
+        table_size <<= 1U;
+    }
+
+    m_displacements.assign(m_entries.size() / 2 + 1, 0);
+
+    std::vector<std::vector<std::size_t>> buckets(m_displacements.size());
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        buckets[(hashes[i] >> 32U) % buckets.size()].push_back(i);
+    }
+    std::vector<std::size_t> order(buckets.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) {
+                         return buckets[a].size() > buckets[b].size();
+                     });
+
+    std::vector<std::size_t> slots;
+    while (table_size <= MAX_TABLE_SIZE) {
+        m_table.assign(table_size, 0);
+        bool success = true;
+
+        for (auto const b : order) {
+            auto const &bucket = buckets[b];
+            if (bucket.empty()) {
+                break;
+            }
+
+            bool placed = false;
+            for (uint32_t d = 0; d < MAX_DISPLACEMENT && !placed; ++d) {
+                m_displacements[b] = d;
+                slots.clear();
+                placed = true;
+                for (auto const i : bucket) {
+                    auto const s = slot(hashes[i]);
+                    if (m_table[s] != 0 || std::find(slots.begin(), slots.end(),
+                                                     s) != slots.end()) {
+                        placed = false;
+                        break;
+                    }
+                    slots.push_back(s);
+                }
+            }
+
+            if (!placed) {
+                success = false;
+                break;
+            }
+
+            for (std::size_t j = 0; j < bucket.size(); ++j) {
+                m_table[slots[j]] = static_cast<uint32_t>(bucket[j] + 1);
+            }
+        }
+
+        if (success) {
+            return;
+        }
+
+        std::fill(m_displacements.begin(), m_displacements.end(), 0);
+        table_size <<= 1U;
+    }
+
+    throw std::runtime_error{"Could not build lookup table for style keys."};
+}
+
+export_key_index_t::result
+export_key_index_t::find(char const *key, unsigned int *flags) const noexcept
+{
+    auto const len = std::strlen(key);
+
+    entry_t const *entry = nullptr;
+    auto const index = m_table[slot(hash(key, len))];
+    if (index != 0) {
+        auto const &e = m_entries[index - 1];
+        if (e.key.size() == len && std::memcmp(e.key.data(), key, len) == 0) {
+            entry = &e;
+        }
+    }
+
+    auto const keep_pos = entry ? entry->keep_pos : NOT_FOUND;
+    if (entry && entry->delete_pos < keep_pos) {
+        return result::drop;
+    }
+
+    for (auto const &wildcard : m_wildcards) {
+        if (wildcard.pos > keep_pos) {
+            break;
+        }
+        if (wild_match(wildcard.pattern.c_str(), key)) {
+            return result::drop;
+        }
+    }
+
+    if (keep_pos == NOT_FOUND) {
+        return result::unknown;
+    }
+
+    *flags |= entry->flags;
+    return result::keep;
+}
+
 unsigned parse_tag_flags(std::string const &flags, int lineno)
 {
     static std::map<std::string, unsigned> const tagflags = {
@@ -15,7 +15,6 @@
 #include "taginfo-impl.hpp"
 #include "tagtransform-c.hpp"
 #include "util.hpp"
-#include "wildcmp.hpp"
 
 namespace {
 
@@ -98,7 +97,9 @@ bool starts_with(char const *input, std::string const &test) noexcept
 
 c_tagtransform_t::c_tagtransform_t(options_t const *options,
                                    export_list_t exlist)
-: m_options(options), m_export_list(std::move(exlist))
+: m_options(options), m_export_list(std::move(exlist)),
+  m_node_keys(m_export_list.get(osmium::item_type::node)),
+  m_way_keys(m_export_list.get(osmium::item_type::way))
 {}
 
 std::unique_ptr<tagtransform_t> c_tagtransform_t::clone() const
@@ -106,22 +107,18 @@ std::unique_ptr<tagtransform_t> c_tagtransform_t::clone() const
     return std::make_unique<c_tagtransform_t>(m_options, m_export_list);
 }
 
-bool c_tagtransform_t::check_key(std::vector<taginfo> const &infos,
+bool c_tagtransform_t::check_key(export_key_index_t const &index,
                                  char const *k, bool *filter,
                                  unsigned int *flags)
 {
-    //go through the actual tags found on the item and keep the ones in the export list
-    for (auto const &info : infos) {
-        if (info.flags & FLAG_DELETE) {
-            if (wild_match(info.name.c_str(), k)) {
-                return false;
-            }
-        } else if (std::strcmp(info.name.c_str(), k) == 0) {
-            *filter = false;
-            *flags |= info.flags;
-
-            return true;
-        }
+    switch (index.find(k, flags)) {
+    case export_key_index_t::result::drop:
+        return false;
+    case export_key_index_t::result::keep:
+        *filter = false;
+        return true;
+    case export_key_index_t::result::unknown:
+        break;
     }
 
     // if we didn't find any tags that we wanted to export
@@ -161,11 +158,8 @@ bool c_tagtransform_t::filter_tags(osmium::OSMObject const &o, bool *polygon,
     unsigned int flags = 0;
     int add_area_tag = 0;
 
-    auto export_type = o.type();
-    if (o.type() == osmium::item_type::relation) {
-        export_type = osmium::item_type::way;
-    }
-    auto const &infos = m_export_list.get(export_type);
+    auto const &keys =
+        o.type() == osmium::item_type::node ? m_node_keys : m_way_keys;
 
     /* We used to only go far enough to determine if it's a polygon or not,
        but now we go through and filter stuff we don't need
@@ -191,7 +185,7 @@ bool c_tagtransform_t::filter_tags(osmium::OSMObject const &o, bool *polygon,
         }
 
         //go through the actual tags found on the item and keep the ones in the export list
-        if (check_key(infos, k, &filter, &flags)) {
+        if (check_key(keys, k, &filter, &flags)) {
             out_tags->add_tag(k, v);
         }
     }
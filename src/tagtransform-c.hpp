@@ -30,11 +30,15 @@ public:
                                 bool *roads, taglist_t *out_tags) override;
 
 private:
-    bool check_key(std::vector<taginfo> const &infos, char const *k,
+    bool check_key(export_key_index_t const &index, char const *k,
                    bool *filter, unsigned int *flags);
 
     options_t const *m_options;
     export_list_t m_export_list;
+
+    // Lookup structures created from m_export_list.
+    export_key_index_t m_node_keys;
+    export_key_index_t m_way_keys;
 };
 
 #endif // OSM2PGSQL_TAGTRANSFORM_C_HPP
@@ -19,20 +19,53 @@ lua_tagtransform_t::lua_tagtransform_t(std::string const *tag_transform_script,
 {
     m_lua_state.reset(luaL_newstate());
     luaL_openlibs(lua_state());
-    if (luaL_dofile(lua_state(), m_lua_file->c_str())) {
+    if (luaL_loadfile(lua_state(), m_lua_file->c_str())) {
         throw fmt_error("Lua tag transform style error: {}.",
                         lua_tostring(lua_state(), -1));
     }
 
-    check_lua_function_exists(NODE_FUNC);
-    check_lua_function_exists(WAY_FUNC);
-    check_lua_function_exists(REL_FUNC);
-    check_lua_function_exists(REL_MEM_FUNC);
+    // Clones load this bytecode, so this only saves reading and compiling
+    // the script again. Each clone still has its own Lua state and runs the
+    // top-level code of the script in run_script(), because a Lua state can
+    // not be shared between threads. Scripts doing expensive work at load
+    // time will still do it once per clone.
+    m_bytecode =
+        std::make_shared<std::string const>(luaX_dump_function(lua_state()));
+
+    run_script();
+}
+
+lua_tagtransform_t::lua_tagtransform_t(lua_tagtransform_t const *other)
+: m_bytecode(other->m_bytecode), m_lua_file(other->m_lua_file),
+  m_extra_attributes(other->m_extra_attributes)
+{
+    m_lua_state.reset(luaL_newstate());
+    luaL_openlibs(lua_state());
+    if (luaL_loadbuffer(lua_state(), m_bytecode->data(), m_bytecode->size(),
+                        m_lua_file->c_str())) {
+        throw fmt_error("Lua tag transform style error: {}.",
+                        lua_tostring(lua_state(), -1));
+    }
+
+    run_script();
 }
 
 std::unique_ptr<tagtransform_t> lua_tagtransform_t::clone() const
 {
-    return std::make_unique<lua_tagtransform_t>(m_lua_file, m_extra_attributes);
+    return std::make_unique<lua_tagtransform_t>(this);
+}
+
+void lua_tagtransform_t::run_script()
+{
+    if (lua_pcall(lua_state(), 0, 0, 0)) {
+        throw fmt_error("Lua tag transform style error: {}.",
+                        lua_tostring(lua_state(), -1));
+    }
+
+    check_lua_function_exists(NODE_FUNC);
+    check_lua_function_exists(WAY_FUNC);
+    check_lua_function_exists(REL_FUNC);
+    check_lua_function_exists(REL_MEM_FUNC);
 }
 
 void lua_tagtransform_t::check_lua_function_exists(char const *func_name)
@@ -10,6 +10,7 @@
  * For a full list of authors see the git log.
  */
 
+#include <memory>
 #include <string>
 
 #include "tagtransform.hpp"
@@ -19,8 +20,18 @@
 class lua_tagtransform_t : public tagtransform_t
 {
 public:
-    explicit lua_tagtransform_t(std::string const *tag_transform_script,
-                                bool extra_attributes);
+    /// Constructor for new objects
+    lua_tagtransform_t(std::string const *tag_transform_script,
+                       bool extra_attributes);
+
+    /// Constructor for cloned objects
+    explicit lua_tagtransform_t(lua_tagtransform_t const *other);
+
+    lua_tagtransform_t(lua_tagtransform_t const &) = delete;
+    lua_tagtransform_t &operator=(lua_tagtransform_t const &) = delete;
+
+    lua_tagtransform_t(lua_tagtransform_t &&) = delete;
+    lua_tagtransform_t &operator=(lua_tagtransform_t &&) = delete;
 
     ~lua_tagtransform_t() noexcept override = default;
 
@@ -42,6 +53,12 @@ private:
     constexpr static char const *const REL_MEM_FUNC =
         "filter_tags_relation_member";
 
+    /**
+     * Run the compiled script on top of the Lua stack and check that it
+     * defines all needed functions.
+     */
+    void run_script();
+
     void check_lua_function_exists(char const *func_name);
 
     struct lua_state_deleter_t
@@ -53,6 +70,12 @@ private:
 
     std::unique_ptr<lua_State, lua_state_deleter_t> m_lua_state;
 
+    /**
+     * The script compiled into a Lua binary chunk. Clones load this instead
+     * of reading and compiling the script file again, but still execute it.
+     */
+    std::shared_ptr<std::string const> m_bytecode;
+
     std::string const *m_lua_file;
     bool m_extra_attributes;
 };
@@ -10,12 +10,14 @@
 #include "thread-pool.hpp"
 
 #include <cassert>
+#include <exception>
 #include <string>
 
 std::chrono::microseconds task_result_t::wait()
 {
     if (m_future.valid()) {
-        m_result = m_future.get();
+        auto const future = std::move(m_future);
+        m_result = future.get();
 
         // Make sure the result is not 0 so it is different than
         // "no result yet".
@@ -26,6 +28,28 @@ std::chrono::microseconds task_result_t::wait()
     return m_result;
 }
 
+std::chrono::microseconds wait_for_tasks(std::vector<task_result_t> *tasks)
+{
+    std::chrono::microseconds run_time{};
+    std::exception_ptr eptr;
+
+    for (auto &task : *tasks) {
+        try {
+            run_time += task.wait();
+        } catch (...) {
+            if (!eptr) {
+                eptr = std::current_exception();
+            }
+        }
+    }
+
+    if (eptr) {
+        std::rethrow_exception(eptr);
+    }
+
+    return run_time;
+}
+
 thread_pool_t::thread_pool_t(unsigned int num_threads)
 : m_work_queue(MAX_QUEUE_SIZE, "work"), m_joiner(&m_threads)
 {
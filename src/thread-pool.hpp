@@ -42,7 +42,17 @@ public:
      */
     void set(std::future<std::chrono::microseconds> &&future)
     {
-        m_future = std::move(future);
+        m_future = future.share();
+    }
+
+    /**
+     * Return a future which other tasks can use to wait for this task to
+     * finish. Only valid until wait() has been called.
+     */
+    std::shared_future<std::chrono::microseconds> const &
+    future() const noexcept
+    {
+        return m_future;
     }
 
     /**
@@ -60,10 +70,19 @@ public:
     std::chrono::microseconds runtime() const noexcept { return m_result; }
 
 private:
-    std::future<std::chrono::microseconds> m_future;
+    std::shared_future<std::chrono::microseconds> m_future;
     std::chrono::microseconds m_result{};
 }; // class task_result_t
 
+/**
+ * Wait for all tasks to finish. If tasks throw exceptions, this still waits
+ * for all other tasks and then rethrows the first exception.
+ *
+ * \return The sum of the runtimes of all tasks that finished successfully.
+ * \throws The first exception thrown by any of the tasks.
+ */
+std::chrono::microseconds wait_for_tasks(std::vector<task_result_t> *tasks);
+
 /**
  * This is a thread pool class. You can submit tasks using the submit()
  * function. Tasks can only return void.
@@ -13,6 +13,8 @@
 
 #include <osmium/util/string.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 
 std::string tile_t::to_zxy() const
@@ -39,6 +41,22 @@ geom::point_t tile_t::center() const noexcept
     return to_world_coords({0.5, 0.5}, 1);
 }
 
+tile_t tile_t::from_point(geom::point_t p, uint32_t zoom) noexcept
+{
+    auto const num_tiles = static_cast<double>(1ULL << zoom);
+
+    auto const x = std::clamp(
+        std::floor((p.x() + HALF_EARTH_CIRCUMFERENCE) / EARTH_CIRCUMFERENCE *
+                   num_tiles),
+        0.0, num_tiles - 1.0);
+    auto const y = std::clamp(
+        std::floor((HALF_EARTH_CIRCUMFERENCE - p.y()) / EARTH_CIRCUMFERENCE *
+                   num_tiles),
+        0.0, num_tiles - 1.0);
+
+    return {zoom, static_cast<uint32_t>(x), static_cast<uint32_t>(y)};
+}
+
 namespace {
 
 // Quadkey implementation uses bit interleaving code from
@@ -264,6 +264,15 @@ public:
      */
     static tile_t from_zxy(std::string const &zxy);
 
+    /**
+     * Construct the tile on the specified zoom level containing the point
+     * given in web mercator (EPSG:3857) coordinates. Points outside the
+     * map are clamped to the tiles at the border of the map.
+     *
+     * \pre \code zoom < 32 \endcode
+     */
+    static tile_t from_point(geom::point_t p, uint32_t zoom) noexcept;
+
 private:
     static constexpr uint32_t INVALID_ZOOM =
         std::numeric_limits<uint32_t>::max();
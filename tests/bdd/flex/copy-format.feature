@@ -0,0 +1,89 @@
+Feature: Test binary COPY format for flex tables
+
+    Scenario: Write all column types in binary COPY format
+        Given the grid
+            | 1 |   |
+            |   | 2 |
+        And the OSM data
+            """
+            n10 v1 dV Tname=Paris,oneway=-1,lanes=3,width=2.5,bridge=yes x10.0 y10.0
+            n11 v1 dV Tname=Nürnberg,oneway=yes,lanes=70000,width=wide x10.0 y10.0
+            w20 v1 dV Thighway=primary Nn1,n2
+            """
+        And the lua style
+            """
+            local pois = osm2pgsql.define_node_table('osm2pgsql_test_pois', {
+                { column = 'name', type = 'text' },
+                { column = 'bridge', type = 'boolean' },
+                { column = 'lanes2', type = 'int2' },
+                { column = 'lanes4', type = 'int4' },
+                { column = 'lanes8', type = 'int8' },
+                { column = 'width', type = 'real' },
+                { column = 'oneway', type = 'direction' },
+                { column = 'htags', type = 'hstore' },
+                { column = 'jtags', type = 'json' },
+                { column = 'btags', type = 'jsonb' },
+                { column = 'geom', type = 'point', projection = 4326 },
+            }, { copy_format = 'binary' })
+
+            local lines = osm2pgsql.define_table{
+                name = 'osm2pgsql_test_lines',
+                ids = { type = 'any', type_column = 'osm_type', id_column = 'osm_id' },
+                columns = {
+                    { column = 'geom', type = 'linestring', projection = 4326 },
+                },
+                copy_format = 'binary'
+            }
+
+            function osm2pgsql.process_node(object)
+                pois:insert{
+                    name = object.tags.name,
+                    bridge = object.tags.bridge,
+                    lanes2 = object.tags.lanes,
+                    lanes4 = object.tags.lanes,
+                    lanes8 = object.tags.lanes,
+                    width = object.tags.width,
+                    oneway = object.tags.oneway,
+                    htags = object.tags,
+                    jtags = object.tags,
+                    btags = object.tags,
+                    geom = object:as_point()
+                }
+            end
+
+            function osm2pgsql.process_way(object)
+                lines:insert{ geom = object:as_linestring() }
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_pois contains exactly
+            | node_id | name     | bridge::text | lanes2 | lanes4 | lanes8 | width | oneway | htags->'name' | jtags->>'name' | btags->>'name' | ST_AsText(geom) |
+            | 10      | Paris    | true         | 3      | 3      | 3      | 2.5   | -1     | Paris         | Paris          | Paris          | POINT(10 10)    |
+            | 11      | Nürnberg | NULL         | NULL   | 70000  | 70000  | NULL  | 1      | Nürnberg      | Nürnberg       | Nürnberg       | POINT(10 10)    |
+
+        Then table osm2pgsql_test_lines contains exactly
+            | osm_type | osm_id | geom!geo |
+            | W        | 20     | 1, 2     |
+
+    Scenario: Binary COPY format is not allowed with sql_type
+        Given the OSM data
+            """
+            n10 v1 dV Tname=Paris x10.0 y10.0
+            """
+        And the lua style
+            """
+            local pois = osm2pgsql.define_node_table('osm2pgsql_test_pois', {
+                { column = 'name', type = 'text', sql_type = 'varchar' },
+            }, { copy_format = 'binary' })
+
+            function osm2pgsql.process_node(object)
+                pois:insert{ name = object.tags.name }
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Can not use binary COPY format for table 'osm2pgsql_test_pois'
+            """
@@ -0,0 +1,137 @@
+Feature: Columns derived from other geometry columns
+
+    Scenario: Derived columns are calculated from the source geometry
+        Given the 0.1 grid with origin 9.0 50.3
+            |  1 |  2 |
+            |  3 |  4 |
+        And the OSM data
+            """
+            w1 Tnatural=water,name=poly Nn1,n2,n4,n3,n1
+            w2 Thighway=primary,name=line Nn1,n2,n4
+            """
+        And the lua style
+            """
+            local polygons = osm2pgsql.define_area_table('osm2pgsql_test_polygons', {
+                { column = 'name', type = 'text' },
+                { column = 'geom', type = 'geometry', projection = 4326 },
+                { column = 'center', type = 'point', projection = 4326,
+                  derive = 'centroid', from = 'geom' },
+                { column = 'area', type = 'real',
+                  derive = 'area', from = 'geom' },
+            })
+
+            local lines = osm2pgsql.define_way_table('osm2pgsql_test_lines', {
+                { column = 'name', type = 'text' },
+                { column = 'geom', type = 'linestring', projection = 4326 },
+                { column = 'geomsimple', type = 'linestring', projection = 4326,
+                  derive = 'simplify', from = 'geom', tolerance = 0.2 },
+                { column = 'length', type = 'real',
+                  derive = 'length', from = 'geom' },
+            })
+
+            function osm2pgsql.process_way(object)
+                if object.tags.natural then
+                    polygons:insert({
+                        name = object.tags.name,
+                        geom = object:as_polygon()
+                    })
+                else
+                    lines:insert({
+                        name = object.tags.name,
+                        geom = object:as_linestring()
+                    })
+                end
+            end
+            """
+        When running osm2pgsql flex
+        Then table osm2pgsql_test_polygons contains
+            | area_id | name | center!geo | area!~0.01 |
+            | 1       | poly | 9.05 50.25 | 0.01       |
+        And table osm2pgsql_test_lines contains
+            | way_id | name | geomsimple!geo | length!~0.01 |
+            | 2      | line | 1, 4           | 0.2          |
+
+    Scenario: Derived column without geometry in source column is NULL
+        Given the OSM data
+            """
+            n1 Tamenity=bench x10 y10
+            """
+        And the lua style
+            """
+            local points = osm2pgsql.define_node_table('osm2pgsql_test_points', {
+                { column = 'geom', type = 'point', projection = 4326 },
+                { column = 'center', type = 'point', derive = 'centroid', from = 'geom' },
+            })
+
+            function osm2pgsql.process_node(object)
+                points:insert({})
+            end
+            """
+        When running osm2pgsql flex
+        Then table osm2pgsql_test_points contains
+            | node_id | center |
+            | 1       | NULL   |
+
+    Scenario: Source column must be defined before derived column
+        Given the OSM data
+            """
+            n1 Tamenity=bench x10 y10
+            """
+        And the lua style
+            """
+            osm2pgsql.define_node_table('osm2pgsql_test_points', {
+                { column = 'center', type = 'point', derive = 'centroid', from = 'geom' },
+                { column = 'geom', type = 'point' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Source column 'geom' of derived column 'center' must be defined before it.
+            """
+
+    Scenario: Derived column type must fit the function
+        Given the OSM data
+            """
+            n1 Tamenity=bench x10 y10
+            """
+        And the lua style
+            """
+            osm2pgsql.define_node_table('osm2pgsql_test_points', {
+                { column = 'geom', type = 'point' },
+                { column = 'area', type = 'int', derive = 'area', from = 'geom' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Derived column 'area' using 'area' must be of type 'real'.
+            """
+
+    Scenario: Derived columns can not be set from Lua
+        Given the OSM data
+            """
+            n1 Tamenity=bench x10 y10
+            """
+        And the lua style
+            """
+            local points = osm2pgsql.define_node_table('osm2pgsql_test_points', {
+                { column = 'geom', type = 'point', projection = 4326 },
+                { column = 'center', type = 'point', derive = 'centroid', from = 'geom' },
+            })
+
+            function osm2pgsql.process_node(object)
+                points:insert({
+                    geom = object:as_point(),
+                    center = object:as_point()
+                })
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Column 'center' is derived and can not be set.
+            """
@@ -0,0 +1,143 @@
+Feature: Change detection with row hashes
+
+    Background:
+        Given the lua style
+            """
+            local eo = osm2pgsql.define_expire_output({
+                table = 'osm2pgsql_test_expire',
+                maxzoom = 1,
+            })
+
+            local the_table = osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'tags', type = 'hstore' },
+                { column = 'geom', type = 'linestring', expire = {{ output = eo }} },
+            }, { detect_changes = true })
+
+            function osm2pgsql.process_way(object)
+                if object.tags.t1 then
+                    the_table:insert{
+                        tags = object.tags,
+                        geom = object:as_linestring()
+                    }
+                end
+            end
+            """
+
+        And the 0.1 grid
+            | 11 | 13 |
+            | 10 | 12 |
+
+        And the OSM data
+            """
+            w11 v1 dV Tt1=yes,name=foo,ref=1 Nn12,n13
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then table osm2pgsql_test_t1 contains exactly
+            | way_id | tags->'name' |
+            | 11     | foo          |
+
+
+    Scenario: unchanged way is not rewritten or expired
+        Given the SQL statement remember_xmin
+            """
+            SELECT set_config('osm2pgsql_test.xmin', xmin::text, false) IS NOT NULL AS ok
+            FROM osm2pgsql_test_t1 WHERE way_id = 11
+            """
+        And the SQL statement same_xmin
+            """
+            SELECT way_id, xmin::text = current_setting('osm2pgsql_test.xmin') AS same
+            FROM osm2pgsql_test_t1
+            """
+        Then statement remember_xmin returns exactly
+            | ok::text |
+            | true     |
+
+        Given the OSM data
+            """
+            w11 v2 dV Tt1=yes,name=foo,ref=1 Nn12,n13
+            """
+
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_t1 contains exactly
+            | way_id | tags->'name' |
+            | 11     | foo          |
+        Then statement same_xmin returns exactly
+            | way_id | same::text |
+            | 11     | true       |
+        Then table osm2pgsql_test_expire contains exactly
+            | zoom | x | y |
+
+
+    Scenario: changed way is rewritten and expired
+        Given the OSM data
+            """
+            w11 v2 dV Tt1=yes,name=bar,ref=1 Nn12,n13
+            """
+
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_t1 contains exactly
+            | way_id | tags->'name' |
+            | 11     | bar          |
+        Then table osm2pgsql_test_expire contains exactly
+            | zoom | x | y |
+            | 1    | 1 | 0 |
+
+
+    Scenario: way that doesn't produce rows any more is deleted
+        Given the OSM data
+            """
+            w11 v2 dV Tname=foo Nn12,n13
+            """
+
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_t1 contains exactly
+            | way_id |
+        Then table osm2pgsql_test_expire contains exactly
+            | zoom | x | y |
+            | 1    | 1 | 0 |
+
+
+    Scenario: hash column name is reserved
+        Given the lua style
+            """
+            osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'row_hash', type = 'int8' },
+            }, { detect_changes = true })
+            """
+        And the OSM data
+            """
+            w11 v1 dV Tt1=yes Nn12,n13
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Column name 'row_hash' is reserved for the row hash
+            """
+
+
+    Scenario: hash column type can not be used for other columns
+        Given the lua style
+            """
+            osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'hash', type = 'row_hash' },
+            })
+            """
+        And the OSM data
+            """
+            w11 v1 dV Tt1=yes Nn12,n13
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Column type 'row_hash' of column 'hash' is reserved for the row hash
+            """
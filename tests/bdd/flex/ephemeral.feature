@@ -0,0 +1,225 @@
+Feature: Ephemeral tables are only used for expiry
+
+    Background:
+        Given the lua style
+            """
+            local eo = osm2pgsql.define_expire_output({
+                table = 'osm2pgsql_test_expire',
+                maxzoom = 1,
+            })
+
+            local the_table = osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'geom', type = 'linestring', expire = {{ output = eo }} },
+            }, { ephemeral = true })
+
+            function osm2pgsql.process_way(object)
+                if object.tags.t1 then
+                    the_table:insert{
+                        geom = object:as_linestring()
+                    }
+                end
+            end
+            """
+
+        Given the SQL statement tables
+            """
+            SELECT count(*) FROM pg_catalog.pg_tables
+            WHERE tablename = 'osm2pgsql_test_t1'
+            """
+
+        And the 0.1 grid
+            | 11 | 13 |
+            | 10 | 12 |
+
+        And the OSM data
+            """
+            w11 v1 dV Tt1=yes Nn12,n13
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then statement tables returns exactly
+            | count |
+            | 0     |
+
+
+    Scenario: new way in ephemeral table is expired
+        Given the OSM data
+            """
+            w10 v1 dV Tt1=yes Nn10,n11
+            """
+
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then statement tables returns exactly
+            | count |
+            | 0     |
+        Then table osm2pgsql_test_expire contains exactly
+            | zoom | x | y |
+            | 1    | 1 | 0 |
+
+
+    Scenario: ephemeral tables are ignored when marking ways for stage 2
+        Given the lua style
+            """
+            local eo = osm2pgsql.define_expire_output({
+                table = 'osm2pgsql_test_expire',
+                maxzoom = 1,
+            })
+
+            local the_table = osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'geom', type = 'linestring', expire = {{ output = eo }} },
+            }, { ephemeral = true })
+
+            local rel_table = osm2pgsql.define_relation_table('osm2pgsql_test_rels', {
+                { column = 'name', type = 'text' },
+            })
+
+            function osm2pgsql.process_way(object)
+                if osm2pgsql.stage == 2 then
+                    the_table:insert{
+                        geom = object:as_linestring()
+                    }
+                end
+            end
+
+            function osm2pgsql.select_relation_members(relation)
+                return { ways = osm2pgsql.way_member_ids(relation) }
+            end
+
+            function osm2pgsql.process_relation(object)
+                rel_table:insert{
+                    name = object.tags.name
+                }
+            end
+            """
+        And the OSM data
+            """
+            w11 v1 dV Tt1=yes Nn12,n13
+            r1 v1 dV Ttype=route,name=foo Mw11@
+            """
+
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then statement tables returns exactly
+            | count |
+            | 0     |
+        Then table osm2pgsql_test_rels contains exactly
+            | relation_id | name |
+            | 1           | foo  |
+
+
+    Scenario: ephemeral tables can't have indexes
+        Given the lua style
+            """
+            osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'geom', type = 'linestring' },
+            }, { ephemeral = true, indexes = {} })
+            """
+        And the OSM data
+            """
+            w10 v1 dV Tt1=yes Nn10,n11
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Can not define indexes on ephemeral table 'osm2pgsql_test_t1'.
+            """
+
+
+    Scenario: rows in ephemeral tables are checked like in normal tables
+        Given the lua style
+            """
+            local eo = osm2pgsql.define_expire_output({
+                table = 'osm2pgsql_test_expire',
+                maxzoom = 1,
+            })
+
+            local the_table = osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'name', type = 'text', not_null = true },
+                { column = 'geom', type = 'linestring', expire = {{ output = eo }} },
+            }, { ephemeral = true })
+
+            local errors = osm2pgsql.define_way_table('osm2pgsql_test_errors', {
+                { column = 'error', type = 'text' },
+                { column = 'col', type = 'text' },
+            })
+
+            function osm2pgsql.process_way(object)
+                if object.tags.t1 then
+                    local ok, err, col = the_table:insert{
+                        name = object.tags.name,
+                        geom = object:as_linestring()
+                    }
+                    if not ok then
+                        errors:insert{ error = err, col = col }
+                    end
+                end
+            end
+            """
+        And the OSM data
+            """
+            w11 v1 dV Tt1=yes,name=foo Nn12,n13
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Given the OSM data
+            """
+            w10 v1 dV Tt1=yes Nn10,n11
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_errors contains exactly
+            | way_id | error                          | col  |
+            | 10     | null value in not null column. | name |
+        Then table osm2pgsql_test_expire has 0 rows
+
+
+    Scenario: geometries of the wrong type are rejected in ephemeral tables
+        Given the lua style
+            """
+            local eo = osm2pgsql.define_expire_output({
+                table = 'osm2pgsql_test_expire',
+                maxzoom = 1,
+            })
+
+            local the_table = osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'geom', type = 'point', expire = {{ output = eo }} },
+            }, { ephemeral = true })
+
+            function osm2pgsql.process_way(object)
+                the_table:insert{
+                    geom = object:as_linestring()
+                }
+            end
+            """
+        And the OSM data
+            """
+            w10 v1 dV Tt1=yes Nn10,n11
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Geometry data for geometry column 'geom' has the wrong type (LINESTRING).
+            """
+
+
+    Scenario: expiry from ephemeral tables in append mode is incomplete
+        Given the OSM data
+            """
+            w11 v2 dV Tt1=yes Nn10,n11
+            """
+
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then the error output contains
+            """
+            Ephemeral table 'osm2pgsql_test_t1' only expires tiles for new geometries
+            """
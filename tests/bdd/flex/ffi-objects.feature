@@ -0,0 +1,133 @@
+Feature: Access to OSM objects through the LuaJIT FFI
+
+    Scenario: The ffi_objects setting must be a boolean
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.ffi_objects = 'yes'
+
+            osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            osm2pgsql.ffi_objects must be a boolean.
+            """
+
+    @config.have_luajit
+    Scenario: Tags can be read with osm2pgsql.ffi.get_tag and has_tag
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench,material=wood
+            n11 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.ffi_objects = true
+
+            local nodes = osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'amenity', type = 'text' },
+                { column = 'material', type = 'text' },
+                { column = 'has_material', type = 'bool' },
+            })
+
+            function osm2pgsql.process_node(object)
+                nodes:insert{
+                    amenity = osm2pgsql.ffi.get_tag(object, 'amenity'),
+                    material = osm2pgsql.ffi.get_tag(object, 'material'),
+                    has_material = osm2pgsql.ffi.has_tag(object, 'material'),
+                }
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_nodes contains exactly
+            | node_id | amenity | material | has_material::text |
+            | 10      | bench   | wood     | true               |
+            | 11      | bench   | NULL     | false              |
+
+    @config.have_luajit
+    Scenario: Tags can be read with osm2pgsql.ffi.get_tags
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench,material=wood
+            n11 v1 dV
+            """
+        And the lua style
+            """
+            local ffi = require('ffi')
+
+            osm2pgsql.ffi_objects = true
+
+            local nodes = osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'all_tags', type = 'text' },
+                { column = 'first_tag', type = 'text' },
+                { column = 'num_tags', type = 'int' },
+            })
+
+            local tags = ffi.new('osm2pgsql_tag_t[?]', 10)
+
+            local function tags_to_string(count)
+                local result = ''
+                for i = 0, count - 1 do
+                    result = result .. ffi.string(tags[i].key) .. '='
+                             .. ffi.string(tags[i].value) .. ';'
+                end
+                return result
+            end
+
+            function osm2pgsql.process_node(object)
+                local num_tags = osm2pgsql.ffi.get_tags(object, tags, 10)
+                local all_tags = tags_to_string(num_tags)
+                local first_tag = tags_to_string(
+                                      osm2pgsql.ffi.get_tags(object, tags, 1))
+                nodes:insert{
+                    all_tags = all_tags,
+                    first_tag = first_tag,
+                    num_tags = num_tags,
+                }
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_nodes contains exactly
+            | node_id | all_tags                     | first_tag      | num_tags |
+            | 10      | amenity=bench;material=wood; | amenity=bench; | 2        |
+            | 11      |                              |                | 0        |
+
+    @config.have_luajit
+    Scenario: OSM objects can not be accessed through the FFI after the callback
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.ffi_objects = true
+
+            osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+
+            local stored_object
+
+            function osm2pgsql.process_node(object)
+                stored_object = object
+            end
+
+            function osm2pgsql.after_nodes()
+                osm2pgsql.ffi.get_tag(stored_object, 'amenity')
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            OSM object not available through the FFI.
+            """
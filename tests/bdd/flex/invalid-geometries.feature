@@ -124,3 +124,66 @@ Feature: Test handling of invalid geometries
             | osm_id |
             | -30    |
 
+
+
+    Scenario: Rows rejected because of an invalid geometry don't expire tiles
+        Given the lua style
+            """
+            local eo = osm2pgsql.define_expire_output({
+                table = 'osm2pgsql_test_expire',
+                maxzoom = 1,
+            })
+
+            local the_table = osm2pgsql.define_way_table('osm2pgsql_test_t1', {
+                { column = 'line', type = 'linestring', expire = {{ output = eo }} },
+                { column = 'other', type = 'linestring' },
+            })
+
+            local errors = osm2pgsql.define_way_table('osm2pgsql_test_errors', {
+                { column = 'error', type = 'text' },
+                { column = 'col', type = 'text' },
+            })
+
+            -- All points of this geometry end up in the same place when
+            -- projected into 3857, so it becomes invalid.
+            local collapsing_geom
+
+            function osm2pgsql.process_way(object)
+                if object.tags.collapse then
+                    collapsing_geom = object:as_linestring()
+                    return
+                end
+                local ok, err, col = the_table:insert{
+                    line = object:as_linestring(),
+                    other = collapsing_geom
+                }
+                if not ok then
+                    errors:insert{ error = err, col = col }
+                end
+            end
+            """
+        And the 0.1 grid
+            | 11 | 13 |
+            | 10 | 12 |
+        And the OSM data
+            """
+            n1 v1 dV x10 y89
+            n2 v1 dV x10 y89.5
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Given the OSM data
+            """
+            w20 v1 dV Tcollapse=yes Nn1,n2
+            w21 v1 dV Tt1=yes Nn10,n11
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_t1 has 0 rows
+        Then table osm2pgsql_test_errors contains exactly
+            | way_id | error             | col   |
+            | 21     | invalid geometry. | other |
+        Then table osm2pgsql_test_expire contains exactly
+            | zoom | x | y |
@@ -0,0 +1,174 @@
+Feature: Lazy OSM objects in Lua
+
+    Background:
+        Given the grid
+            | 10 | 11 |
+            | 12 |    |
+
+    Scenario Outline: Lazy objects have the same contents as normal ones
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            w20 v1 dV Thighway=primary,name=Main Nn10,n11,n12
+            r30 v1 dV Ttype=route,route=bus Mn10@stop,w20@
+            """
+        And the lua style
+            """
+            osm2pgsql.lazy_objects = <lazy>
+
+            local dtable = osm2pgsql.define_table{
+                name = 'osm2pgsql_test_objects',
+                ids = { type = 'any', type_column = 'osm_type', id_column = 'osm_id' },
+                columns = {
+                    { column = 'tags', type = 'hstore' },
+                    { column = 'refs', type = 'text' },
+                    { column = 'is_closed', type = 'bool' },
+                }
+            }
+
+            function osm2pgsql.process_node(object)
+                dtable:insert({ tags = object.tags })
+            end
+
+            function osm2pgsql.process_way(object)
+                dtable:insert({
+                    tags = object.tags,
+                    refs = table.concat(object.nodes, ','),
+                    is_closed = object.is_closed
+                })
+            end
+
+            function osm2pgsql.process_relation(object)
+                local refs = {}
+                for _, member in ipairs(object.members) do
+                    refs[#refs + 1] = member.type .. member.ref .. member.role
+                end
+                object.tags.type = nil
+                dtable:insert({
+                    tags = object.tags,
+                    refs = table.concat(refs, ',')
+                })
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_objects contains exactly
+            | osm_type | osm_id | tags->'amenity' | tags->'name' | tags->'type' | refs        | is_closed |
+            | N        | 10     | bench           | NULL         | NULL         | NULL        | NULL      |
+            | W        | 20     | NULL            | Main         | NULL         | 10,11,12    | False     |
+            | R        | 30     | NULL            | NULL         | NULL         | n10stop,w20 | NULL      |
+
+        Examples:
+            | lazy  |
+            | false |
+            | true  |
+
+    Scenario: Lazy objects can not be accessed after the callback returned
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            n11 v1 dV Tamenity=post_box
+            """
+        And the lua style
+            """
+            osm2pgsql.lazy_objects = true
+
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+
+            local last
+
+            function osm2pgsql.process_node(object)
+                if last then
+                    dtable:insert({ tags = last.tags })
+                end
+                last = object
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Can not access 'tags' of OSM object outside the callback it was passed to.
+            """
+
+    Scenario: Fields accessed in the callback stay available
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            n11 v1 dV Tamenity=post_box
+            """
+        And the lua style
+            """
+            osm2pgsql.lazy_objects = true
+
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'amenity', type = 'text' },
+            })
+
+            local last
+
+            function osm2pgsql.process_node(object)
+                if last then
+                    dtable:insert({ amenity = last.tags.amenity })
+                end
+                local _ = object.tags
+                last = object
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_nodes contains exactly
+            | node_id | amenity |
+            | 11      | bench   |
+
+    Scenario: Lazy fields are returned by pairs() where __pairs is supported
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.lazy_objects = true
+
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'has_tags', type = 'bool' },
+            })
+
+            function osm2pgsql.process_node(object)
+                local has_tags = false
+                for k, _ in pairs(object) do
+                    if k == 'tags' then
+                        has_tags = true
+                    end
+                end
+                -- Lua 5.1 and LuaJIT don't support the __pairs metamethod.
+                dtable:insert({ has_tags = has_tags or _VERSION == 'Lua 5.1' })
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_nodes contains exactly
+            | node_id | has_tags::text |
+            | 10      | true           |
+
+    Scenario: The lazy_objects setting must be a boolean
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.lazy_objects = 'yes'
+
+            osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            osm2pgsql.lazy_objects must be a boolean.
+            """
@@ -49,3 +49,37 @@ Feature: Flex output uses a Lua config file
             prefix=planet_osm
             """
 
+
+    Scenario: Timings of the Lua code are logged with --log-lua-profile
+        Given the OSM data
+            """
+            n1 Tamenity=bench x1 y1
+            """
+        And the lua style
+            """
+            local points = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'geom', type = 'point' },
+            })
+
+            function osm2pgsql.process_node(object)
+                points:insert({ geom = object:as_point():transform(3857) })
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --log-lua-profile=lines |
+        Then the error output contains
+            """
+            Lua profile
+            """
+        And the error output contains
+            """
+            process_node
+            """
+        And the error output contains
+            """
+            OSMObject.as_point
+            """
+        And the error output contains
+            """
+            Geometry.transform
+            """
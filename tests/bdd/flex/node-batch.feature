@@ -0,0 +1,111 @@
+Feature: Processing nodes in batches
+
+    Background:
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench x1 y1
+            n11 v1 dV Tamenity=post_box x2 y2
+            n12 v1 dV Tshop=bakery x3 y3
+            n13 v1 dV x4 y4
+            """
+
+    Scenario: All tagged nodes are passed to process_node_batch
+        Given the lua style
+            """
+            local points = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'amenity', type = 'text' },
+                { column = 'geom', type = 'point', projection = 4326 },
+            })
+
+            function osm2pgsql.process_node_batch(objects)
+                for _, object in ipairs(objects) do
+                    if object.tags.amenity then
+                        points:insert({
+                            amenity = object.tags.amenity,
+                            geom = object:as_point()
+                        }, object)
+                    end
+                end
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_point contains exactly
+            | node_id | amenity  | geom!geo |
+            | 10      | bench    | 1 1      |
+            | 11      | post_box | 2 2      |
+
+    Scenario: Updates with process_node_batch
+        Given the lua style
+            """
+            local points = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'amenity', type = 'text' },
+                { column = 'geom', type = 'point', projection = 4326 },
+            })
+
+            function osm2pgsql.process_node_batch(objects)
+                for _, object in ipairs(objects) do
+                    if object.tags.amenity then
+                        points:insert({
+                            amenity = object.tags.amenity,
+                            geom = object:as_point()
+                        }, object)
+                    end
+                end
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Given the OSM data
+            """
+            n10 v2 dV Tshop=bakery x1 y1
+            n12 v2 dV Tamenity=bench x3 y3
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_point contains exactly
+            | node_id | amenity  | geom!geo |
+            | 11      | post_box | 2 2      |
+            | 12      | bench    | 3 3      |
+
+    Scenario: Insert in process_node_batch needs the object
+        Given the lua style
+            """
+            local points = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'amenity', type = 'text' },
+            })
+
+            function osm2pgsql.process_node_batch(objects)
+                for _, object in ipairs(objects) do
+                    points:insert({ amenity = object.tags.amenity })
+                end
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Need three parameters in process_node_batch()
+            """
+
+    Scenario: Can not use process_node and process_node_batch together
+        Given the lua style
+            """
+            osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'amenity', type = 'text' },
+            })
+
+            function osm2pgsql.process_node(object)
+            end
+
+            function osm2pgsql.process_node_batch(objects)
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Only one of osm2pgsql.process_node and osm2pgsql.process_node_batch can be defined.
+            """
@@ -0,0 +1,194 @@
+Feature: Test flex config with tables partitioned by tile
+
+    Background:
+        Given the SQL statement partitions
+            """
+            SELECT c.relname AS partition,
+                   (SELECT count(*) FROM pg_catalog.pg_index i
+                    WHERE i.indrelid = c.oid) AS indexes
+            FROM pg_catalog.pg_inherits h, pg_catalog.pg_class c
+            WHERE h.inhparent = 'osm2pgsql_test_point'::regclass
+                  AND h.inhrelid = c.oid
+            """
+
+        Given the SQL statement rows_per_partition
+            """
+            SELECT tableoid::regclass::text AS partition,
+                   min("partition") AS num,
+                   count(*)
+            FROM osm2pgsql_test_point
+            GROUP BY tableoid
+            """
+
+    Scenario Outline: Import into partitioned table
+        Given the input file 'liechtenstein-2013-08-03.osm.pbf'
+        And the lua style
+            """
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'tags', type = 'hstore' },
+                { column = 'geom', type = 'point', not_null = true },
+            }, { partition_zoom = 1, cluster = '<cluster>' })
+
+            function osm2pgsql.process_node(data)
+                dtable:insert({
+                    tags = data.tags,
+                    geom = data:as_point()
+                })
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then table osm2pgsql_test_point has 1562 rows
+        Then statement partitions returns exactly
+            | partition               | indexes |
+            | osm2pgsql_test_point_p0 | 2       |
+            | osm2pgsql_test_point_p1 | 2       |
+            | osm2pgsql_test_point_p2 | 2       |
+            | osm2pgsql_test_point_p3 | 2       |
+        Then statement rows_per_partition returns exactly
+            | partition               | num | count |
+            | osm2pgsql_test_point_p1 | 1   | 1562  |
+
+        Examples:
+            | cluster |
+            | auto    |
+            | sort    |
+            | no      |
+
+    Scenario: Updates are written into the right partition
+        Given the OSM data
+            """
+            n1 v1 dV Tamenity=bench x10 y10
+            n2 v1 dV Tamenity=bench x-10 y-10
+            """
+        And the lua style
+            """
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'tags', type = 'hstore' },
+                { column = 'geom', type = 'point', not_null = true },
+            }, { partition_zoom = 1 })
+
+            function osm2pgsql.process_node(data)
+                dtable:insert({
+                    tags = data.tags,
+                    geom = data:as_point()
+                })
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then statement rows_per_partition returns exactly
+            | partition               | num | count |
+            | osm2pgsql_test_point_p1 | 1   | 1     |
+            | osm2pgsql_test_point_p2 | 2   | 1     |
+
+        Given the OSM data
+            """
+            n1 v2 dV Tamenity=bench x-10 y10
+            n2 v2 dD
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_point contains exactly
+            | node_id |
+            | 1       |
+        Then statement rows_per_partition returns exactly
+            | partition               | num | count |
+            | osm2pgsql_test_point_p0 | 0   | 1     |
+
+    Scenario: Updates filling a partition buffer are not deleted again
+        Given the OSM data format string
+            """
+            {chr(10).join('n' + str(i) + ' v1 dV Tamenity=bench x10 y10' for i in range(1, 51))}
+            """
+        And the lua style
+            """
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'amenity', type = 'text' },
+                { column = 'padding', type = 'text' },
+                { column = 'geom', type = 'point', not_null = true },
+            }, { partition_zoom = 1 })
+
+            -- Large rows fill up the COPY buffer of the partition long
+            -- before the deletes on the parent table are sent.
+            local padding = string.rep('x', 100000)
+
+            function osm2pgsql.process_node(data)
+                dtable:insert({
+                    amenity = data.tags.amenity,
+                    padding = padding,
+                    geom = data:as_point()
+                })
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then statement rows_per_partition returns exactly
+            | partition               | num | count |
+            | osm2pgsql_test_point_p1 | 1   | 50    |
+
+        Given the OSM data format string
+            """
+            {chr(10).join('n' + str(i) + ' v2 dV Tamenity=table x10 y10' for i in range(1, 51))}
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then statement rows_per_partition returns exactly
+            | partition               | num | count |
+            | osm2pgsql_test_point_p1 | 1   | 50    |
+        Then table osm2pgsql_test_point doesn't contain
+            | amenity |
+            | bench   |
+
+    Scenario: Partitioned table needs a geometry column
+        Given the input file 'liechtenstein-2013-08-03.osm.pbf'
+        And the lua style
+            """
+            osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'tags', type = 'hstore' },
+            }, { partition_zoom = 1 })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Partitioned table 'osm2pgsql_test_point' must have a geometry column.
+            """
+
+    Scenario: Partition zoom is limited
+        Given the input file 'liechtenstein-2013-08-03.osm.pbf'
+        And the lua style
+            """
+            osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'geom', type = 'point' },
+            }, { partition_zoom = 5 })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            The 'partition_zoom' table option must be between 1 and 4.
+            """
+
+    Scenario: Index names can not be used on partitioned tables
+        Given the input file 'liechtenstein-2013-08-03.osm.pbf'
+        And the lua style
+            """
+            osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'geom', type = 'point' },
+            }, {
+                partition_zoom = 1,
+                indexes = {{ column = 'geom', method = 'gist', name = 'foo' }}
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Can not set index name 'foo' on partitioned table 'osm2pgsql_test_point'.
+            """
@@ -0,0 +1,28 @@
+Feature: Test flex config with sorting instead of clustering
+
+    Background:
+        Given the input file 'liechtenstein-2013-08-03.osm.pbf'
+
+        And the lua style
+            """
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'tags', type = 'hstore' },
+                { column = 'geom', type = 'point', not_null = true },
+            }, { cluster = 'sort' })
+
+            function osm2pgsql.process_node(data)
+                dtable:insert({
+                    tags = data.tags,
+                    geom = data:as_point()
+                })
+            end
+            """
+
+    Scenario: Import non-slim with sorting
+        When running osm2pgsql flex
+        Then table osm2pgsql_test_point has 1562 rows
+
+    Scenario: Import slim with sorting
+        When running osm2pgsql flex with parameters
+            | --slim |
+        Then table osm2pgsql_test_point has 1562 rows
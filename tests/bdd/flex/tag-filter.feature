@@ -0,0 +1,183 @@
+Feature: Tag filter in the Lua config
+
+    Background:
+        Given the grid
+            | 10 | 11 |
+            | 12 |    |
+
+    Scenario: Only objects matching the tag filter are processed
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            n11 v1 dV Thighway=traffic_signals
+            n12 v1 dV Thighway=crossing,addr:street=Main
+            n13 v1 dV Tcreated_by=JOSM x3 y3
+            n14 v1 dV x4 y4
+            w20 v1 dV Thighway=primary Nn10,n11,n12
+            w21 v1 dV Tbuilding=yes Nn10,n11,n12,n10
+            r30 v1 dV Ttype=route,route=bus Mw20@
+            """
+        And the lua style
+            """
+            osm2pgsql.tag_filter = {
+                node = { 'amenity', 'highway=traffic_signals', 'addr:*' },
+                way = { 'highway' },
+                relation = {}
+            }
+
+            local dtable = osm2pgsql.define_table{
+                name = 'osm2pgsql_test_objects',
+                ids = { type = 'any', type_column = 'osm_type', id_column = 'osm_id' },
+                columns = {
+                    { column = 'tagged', type = 'bool' },
+                }
+            }
+
+            local function add(object)
+                dtable:insert({ tagged = next(object.tags) ~= nil })
+            end
+
+            osm2pgsql.process_node = add
+            osm2pgsql.process_untagged_node = add
+            osm2pgsql.process_way = add
+            osm2pgsql.process_relation = add
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_objects contains exactly
+            | osm_type | osm_id | tagged |
+            | N        | 10     | True   |
+            | N        | 11     | True   |
+            | N        | 12     | True   |
+            | N        | 14     | False  |
+            | W        | 20     | True   |
+
+    Scenario: Objects not matching the filter any more are removed in updates
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            n11 v1 dV Tamenity=post_box
+            """
+        And the lua style
+            """
+            osm2pgsql.tag_filter = { node = { 'amenity=bench' } }
+
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'amenity', type = 'text' },
+            })
+
+            function osm2pgsql.process_node(object)
+                dtable:insert({ amenity = object.tags.amenity })
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then table osm2pgsql_test_nodes contains exactly
+            | node_id | amenity |
+            | 10      | bench   |
+
+        Given the OSM data
+            """
+            n10 v2 dV Tamenity=waste_basket
+            n11 v2 dV Tamenity=bench
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_nodes contains exactly
+            | node_id | amenity |
+            | 11      | bench   |
+
+    Scenario: The tag filter is also used for ways reprocessed in stage 2
+        Given the OSM data
+            """
+            w20 v1 dV Thighway=primary Nn10,n11
+            w21 v1 dV Tbuilding=yes Nn10,n11,n12,n10
+            r30 v1 dV Ttype=route,route=bus Mw20@,w21@
+            """
+        And the lua style
+            """
+            osm2pgsql.tag_filter = { way = { 'highway' } }
+
+            local dtable = osm2pgsql.define_way_table('osm2pgsql_test_ways', {
+                { column = 'stage', type = 'int' },
+            })
+
+            function osm2pgsql.process_way(object)
+                dtable:insert({ stage = osm2pgsql.stage })
+            end
+
+            function osm2pgsql.select_relation_members(relation)
+                return { ways = osm2pgsql.way_member_ids(relation) }
+            end
+
+            function osm2pgsql.process_relation(object)
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Then table osm2pgsql_test_ways contains exactly
+            | way_id | stage |
+            | 20     | 2     |
+
+    Scenario: The tag filter must be a table
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.tag_filter = 'amenity'
+
+            osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            osm2pgsql.tag_filter must be a table.
+            """
+
+    Scenario: The tag filter only allows object types as keys
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.tag_filter = { nodes = { 'amenity' } }
+
+            osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            osm2pgsql.tag_filter can only contain the fields 'node', 'way', and 'relation'.
+            """
+
+    Scenario: The tag filter patterns must be strings
+        Given the OSM data
+            """
+            n10 v1 dV Tamenity=bench
+            """
+        And the lua style
+            """
+            osm2pgsql.tag_filter = { way = { 'highway', 17 } }
+
+            osm2pgsql.define_node_table('osm2pgsql_test_nodes', {
+                { column = 'tags', type = 'hstore' },
+            })
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            osm2pgsql.tag_filter.way must be an array of strings.
+            """
@@ -0,0 +1,44 @@
+Feature: Import into unlogged tables
+
+    Background:
+        Given the input file 'liechtenstein-2013-08-03.osm.pbf'
+
+        Given the SQL statement persistence
+            """
+            SELECT relname, relpersistence FROM pg_catalog.pg_class
+            WHERE relname IN ('osm2pgsql_test_point', 'planet_osm_nodes',
+                              'planet_osm_ways', 'planet_osm_rels')
+            """
+
+    Scenario Outline: Tables are set to logged after the import
+        Given the lua style
+            """
+            local dtable = osm2pgsql.define_node_table('osm2pgsql_test_point', {
+                { column = 'tags', type = 'hstore' },
+                { column = 'geom', type = 'point', not_null = true },
+            }, { cluster = '<cluster>' })
+
+            function osm2pgsql.process_node(data)
+                dtable:insert({
+                    tags = data.tags,
+                    geom = data:as_point()
+                })
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | --unlogged |
+
+        Then table osm2pgsql_test_point has 1562 rows
+        Then statement persistence returns exactly
+            | relname              | relpersistence |
+            | osm2pgsql_test_point | p              |
+            | planet_osm_nodes     | p              |
+            | planet_osm_ways      | p              |
+            | planet_osm_rels      | p              |
+
+        Examples:
+            | cluster |
+            | auto    |
+            | sort    |
+            | no      |
+
@@ -0,0 +1,139 @@
+Feature: Processing ways in batches
+
+    Background:
+        Given the grid
+            | 10 | 11 |
+            | 12 | 13 |
+        And the OSM data
+            """
+            w20 v1 dV Thighway=primary Nn10,n11
+            w21 v1 dV Thighway=secondary Nn12,n13
+            w22 v1 dV Tbuilding=yes Nn10,n11,n13,n12,n10
+            w23 v1 dV Nn11,n13
+            """
+
+    Scenario: All tagged ways are passed to process_way_batch
+        Given the lua style
+            """
+            local lines = osm2pgsql.define_way_table('osm2pgsql_test_line', {
+                { column = 'highway', type = 'text' },
+                { column = 'geom', type = 'linestring', projection = 4326 },
+            })
+
+            function osm2pgsql.process_way_batch(objects)
+                for _, object in ipairs(objects) do
+                    if object.tags.highway then
+                        lines:insert({
+                            highway = object.tags.highway,
+                            geom = object:as_linestring()
+                        }, object)
+                    end
+                end
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_line contains exactly
+            | way_id | highway   | geom!geo |
+            | 20     | primary   | 10, 11   |
+            | 21     | secondary | 12, 13   |
+
+    Scenario: Geometries of all ways in a batch can be used in any order
+        Given the lua style
+            """
+            local lines = osm2pgsql.define_way_table('osm2pgsql_test_line', {
+                { column = 'geom', type = 'linestring', projection = 4326 },
+            })
+
+            function osm2pgsql.process_way_batch(objects)
+                local geoms = {}
+                for i = #objects, 1, -1 do
+                    geoms[i] = objects[i]:as_linestring()
+                end
+                for i, object in ipairs(objects) do
+                    lines:insert({ geom = geoms[i] }, object)
+                end
+            end
+            """
+        When running osm2pgsql flex
+
+        Then table osm2pgsql_test_line contains exactly
+            | way_id | geom!geo           |
+            | 20     | 10, 11             |
+            | 21     | 12, 13             |
+            | 22     | 10, 11, 13, 12, 10 |
+
+    Scenario: Updates with process_way_batch
+        Given the lua style
+            """
+            local lines = osm2pgsql.define_way_table('osm2pgsql_test_line', {
+                { column = 'highway', type = 'text' },
+                { column = 'geom', type = 'linestring', projection = 4326 },
+            })
+
+            function osm2pgsql.process_way_batch(objects)
+                for _, object in ipairs(objects) do
+                    if object.tags.highway then
+                        lines:insert({
+                            highway = object.tags.highway,
+                            geom = object:as_linestring()
+                        }, object)
+                    end
+                end
+            end
+            """
+        When running osm2pgsql flex with parameters
+            | --slim |
+
+        Given the OSM data
+            """
+            w20 v2 dV Tbuilding=yes Nn10,n11
+            w22 v2 dV Thighway=tertiary Nn10,n12
+            """
+        When running osm2pgsql flex with parameters
+            | --slim | -a |
+
+        Then table osm2pgsql_test_line contains exactly
+            | way_id | highway   | geom!geo |
+            | 21     | secondary | 12, 13   |
+            | 22     | tertiary  | 10, 12   |
+
+    Scenario: Insert in process_way_batch needs the object
+        Given the lua style
+            """
+            local lines = osm2pgsql.define_way_table('osm2pgsql_test_line', {
+                { column = 'highway', type = 'text' },
+            })
+
+            function osm2pgsql.process_way_batch(objects)
+                for _, object in ipairs(objects) do
+                    lines:insert({ highway = object.tags.highway })
+                end
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Need three parameters in process_way_batch()
+            """
+
+    Scenario: Can not use process_way and process_way_batch together
+        Given the lua style
+            """
+            osm2pgsql.define_way_table('osm2pgsql_test_line', {
+                { column = 'highway', type = 'text' },
+            })
+
+            function osm2pgsql.process_way(object)
+            end
+
+            function osm2pgsql.process_way_batch(objects)
+            end
+            """
+        When running osm2pgsql flex
+        Then execution fails
+        And the error output contains
+            """
+            Only one of osm2pgsql.process_way and osm2pgsql.process_way_batch can be defined.
+            """
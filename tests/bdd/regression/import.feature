@@ -175,3 +175,28 @@ Feature: Imports of the test database
         Then table planet_osm_polygon contains
             | count(*) | every(tags ?& ARRAY['osm_user', 'osm_version', 'osm_uid', 'osm_changeset']) |
             | 4131     | True |
+
+
+    Scenario: Import slim into unlogged tables
+        Given the SQL statement persistence
+            """
+            SELECT relname, relpersistence FROM pg_catalog.pg_class
+            WHERE relname IN ('planet_osm_point', 'planet_osm_line',
+                              'planet_osm_roads', 'planet_osm_polygon',
+                              'planet_osm_nodes', 'planet_osm_ways',
+                              'planet_osm_rels')
+            """
+        When running osm2pgsql pgsql with parameters
+            | --slim | --unlogged |
+
+        Then table planet_osm_point has 1342 rows
+        And table planet_osm_polygon has 4130 rows
+        And statement persistence returns exactly
+            | relname            | relpersistence |
+            | planet_osm_point   | p              |
+            | planet_osm_line    | p              |
+            | planet_osm_roads   | p              |
+            | planet_osm_polygon | p              |
+            | planet_osm_nodes   | p              |
+            | planet_osm_ways    | p              |
+            | planet_osm_rels    | p              |
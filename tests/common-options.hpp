@@ -85,6 +85,12 @@ public:
         return *this;
     }
 
+    opt_t &num_procs(unsigned int num) noexcept
+    {
+        m_opt.num_procs = num;
+        return *this;
+    }
+
     opt_t &extra_attributes() noexcept
     {
         m_opt.extra_attributes = true;
@@ -9,7 +9,9 @@
 
 #include <catch.hpp>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -229,3 +231,61 @@ TEST_CASE("copy_mgr_t: Insert something, insert more, roll back, insert "
     CHECK(res.get(0, 0) == "good");
     CHECK(res.get(1, 0) == "better");
 }
+
+TEST_CASE("copy_mgr_t: Insert in binary format")
+{
+    copy_mgr_t mgr{std::make_shared<db_copy_thread_t>(db.connection_params())};
+
+    auto const t = setup_table("s int2, i int4, r real, b bool, t text, "
+                               "h hstore, j jsonb, n text");
+    t->set_binary(9);
+
+    mgr.new_binary_line(t);
+    mgr.add_binary_column(int64_t{-12345678901});
+    mgr.add_binary_column(int16_t{-4457});
+    mgr.add_binary_column(int32_t{70000});
+    mgr.add_binary_column(1.5F);
+    mgr.add_binary_column(true);
+    mgr.add_binary_column(std::string_view{"va\tr\n\\"});
+    mgr.new_binary_hash();
+    mgr.add_binary_hash_elem("one", "two");
+    mgr.add_binary_hash_elem("key\t1", "\"value\"");
+    mgr.finish_binary_hash();
+    mgr.add_binary_jsonb_column(R"({"a":[1,2]})");
+    mgr.add_binary_null_column();
+    mgr.finish_line();
+    mgr.sync();
+
+    check_row({"-12345678901", "-4457", "70000", "1.5", "t", "va\tr\n\\"});
+
+    auto const conn = db.connect();
+    CHECK(conn.result_as_string("SELECT h->'one' FROM test_copy_mgr") ==
+          "two");
+    CHECK(conn.result_as_string("SELECT h->E'key\\t1' FROM test_copy_mgr") ==
+          "\"value\"");
+    CHECK(conn.result_as_string("SELECT j->>'a' FROM test_copy_mgr") ==
+          "[1, 2]");
+    CHECK(conn.get_count("test_copy_mgr", "n IS NULL") == 1);
+}
+
+TEST_CASE("copy_mgr_t: Insert with small buffer size")
+{
+    copy_mgr_t mgr{std::make_shared<db_copy_thread_t>(db.connection_params()),
+                   1024};
+
+    auto const t = setup_table("t text");
+
+    // Rows fill up the buffer several times.
+    std::string const text(100, 'x');
+    for (int i = 0; i < 100; ++i) {
+        mgr.new_line(t);
+        mgr.add_column(i);
+        mgr.add_column(text);
+        mgr.finish_line();
+    }
+    mgr.sync();
+
+    auto const conn = db.connect();
+    CHECK(conn.get_count("test_copy_mgr") == 100);
+    CHECK(conn.get_count("test_copy_mgr", "length(t) = 100") == 100);
+}
@@ -0,0 +1,101 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "common-pg.hpp"
+
+#include "expire-from-db.hpp"
+#include "tile.hpp"
+
+#include <sstream>
+
+namespace {
+
+testing::pg::tempdb_t db;
+
+idlist_t read_ids_from_string(std::string const &data)
+{
+    std::istringstream input{data};
+    return read_ids(input);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Read ids from input", "[NoDB]")
+{
+    auto const ids = read_ids_from_string("17\n3\n  12 \r\n\n3\n-5\t\n");
+    REQUIRE(ids.size() == 4);
+    REQUIRE(ids[0] == -5);
+    REQUIRE(ids[1] == 3);
+    REQUIRE(ids[2] == 12);
+    REQUIRE(ids[3] == 17);
+}
+
+TEST_CASE("Read ids from empty input", "[NoDB]")
+{
+    REQUIRE(read_ids_from_string("").empty());
+    REQUIRE(read_ids_from_string("\n  \n\r\n").empty());
+}
+
+TEST_CASE("Read ids from input with invalid id fails", "[NoDB]")
+{
+    REQUIRE_THROWS_WITH(read_ids_from_string("17\nabc\n"),
+                        "Invalid id 'abc' in line 2.");
+    REQUIRE_THROWS_WITH(read_ids_from_string("17\n18 19\n"),
+                        "Invalid id '18 19' in line 2.");
+    REQUIRE_THROWS_WITH(read_ids_from_string("n17\n"),
+                        "Invalid id 'n17' in line 1.");
+    REQUIRE_THROWS_WITH(read_ids_from_string("99999999999999999999\n"),
+                        "Invalid id '99999999999999999999' in line 1.");
+}
+
+TEST_CASE("Expire tiles of geometries in database table")
+{
+    auto const conn = db.connect();
+    conn.exec("DROP TABLE IF EXISTS test_expire");
+    conn.exec("CREATE TABLE test_expire (osm_id int8,"
+              " geom geometry(Point, 4326))");
+    conn.exec("INSERT INTO test_expire VALUES"
+              " (1, ST_SetSRID(ST_MakePoint(10, 10), 4326)),"
+              " (2, ST_SetSRID(ST_MakePoint(-100, 70), 4326)),"
+              " (3, ST_SetSRID(ST_MakePoint(100, -10), 4326)),"
+              " (4, NULL)");
+
+    expire_db_config_t db_config;
+    db_config.connection_params = db.connection_params();
+    db_config.table = "test_expire";
+    db_config.num_threads = 2;
+
+    expire_config_t expire_config;
+    expire_config.buffer = 0.0;
+
+    SECTION("some ids")
+    {
+        idlist_t const ids{1, 2, 4, 5};
+        auto const tiles = expire_from_db(db_config, ids, expire_config, 2);
+
+        REQUIRE(tiles.size() == 2);
+        REQUIRE(tiles[0] == tile_t(2, 0, 0).quadkey());
+        REQUIRE(tiles[1] == tile_t(2, 2, 1).quadkey());
+    }
+
+    SECTION("no ids")
+    {
+        idlist_t const ids{};
+        REQUIRE(expire_from_db(db_config, ids, expire_config, 2).empty());
+    }
+
+    SECTION("unknown table")
+    {
+        db_config.table = "does_not_exist";
+        idlist_t const ids{1};
+        REQUIRE_THROWS(expire_from_db(db_config, ids, expire_config, 2));
+    }
+}
@@ -9,6 +9,7 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
 #include <random>
 #include <set>
 
@@ -299,24 +300,42 @@ TEST_CASE("expire longer diagonal line", "[NoDB]")
         expire_config_t{});
 
     auto const tiles = get_tiles_unordered(&et, zoom);
-    REQUIRE(tiles.size() == 14);
+    REQUIRE(tiles.size() == 10);
 
     CHECK(tiles.count(tile_t(18, 140219, 82050)) == 1);
-    CHECK(tiles.count(tile_t(18, 140220, 82050)) == 1);
     CHECK(tiles.count(tile_t(18, 140219, 82051)) == 1);
     CHECK(tiles.count(tile_t(18, 140220, 82051)) == 1);
-    CHECK(tiles.count(tile_t(18, 140219, 82052)) == 1);
     CHECK(tiles.count(tile_t(18, 140220, 82052)) == 1);
-    CHECK(tiles.count(tile_t(18, 140221, 82052)) == 1);
     CHECK(tiles.count(tile_t(18, 140220, 82053)) == 1);
     CHECK(tiles.count(tile_t(18, 140221, 82053)) == 1);
     CHECK(tiles.count(tile_t(18, 140221, 82054)) == 1);
     CHECK(tiles.count(tile_t(18, 140221, 82055)) == 1);
     CHECK(tiles.count(tile_t(18, 140222, 82055)) == 1);
-    CHECK(tiles.count(tile_t(18, 140221, 82056)) == 1);
     CHECK(tiles.count(tile_t(18, 140222, 82056)) == 1);
 }
 
+TEST_CASE("expire line with buffer", "[NoDB]")
+{
+    uint32_t const zoom = 18;
+    expire_tiles_t et{zoom, defproj};
+
+    expire_config_t expire_config;
+    expire_config.buffer = 1.0;
+
+    et.from_geometry(
+        geom::linestring_t{{1398725.0, 7493354.0}, {1399030.0, 7493354.0}},
+        expire_config);
+
+    auto const tiles = get_tiles_unordered(&et, zoom);
+    REQUIRE(tiles.size() == 15);
+
+    for (uint32_t x = 140220; x <= 140224; ++x) {
+        for (uint32_t y = 82054; y <= 82056; ++y) {
+            CHECK(tiles.count(tile_t(18, x, y)) == 1);
+        }
+    }
+}
+
 /**
  * Test tile expiry on two zoom levels.
  */
@@ -476,6 +495,49 @@ TEST_CASE("merge overlapping expire sets", "[NoDB]")
     }
 }
 
+/**
+ * Appending overlapping sets gives the union of the sets and leaves the
+ * other object empty.
+ */
+TEST_CASE("append overlapping expire sets", "[NoDB]")
+{
+    uint32_t const zoom = 18;
+
+    for (int i = 0; i < 100; ++i) {
+        expire_tiles_t et{zoom, defproj};
+        expire_tiles_t et1{zoom, defproj};
+
+        auto check_set1 = generate_random(zoom, 100);
+        expire_centroids(&et, check_set1);
+
+        auto check_set2 = generate_random(zoom, 100);
+        expire_centroids(&et1, check_set2);
+        expire_centroids(&et1, check_set1);
+
+        et.append_and_clear(&et1);
+        CHECK(et1.empty());
+
+        check_set1.merge(check_set2);
+
+        auto const set = get_tiles_unordered(&et, zoom);
+
+        CHECK(set == check_set1);
+    }
+}
+
+TEST_CASE("clear expire set", "[NoDB]")
+{
+    uint32_t const zoom = 18;
+
+    expire_tiles_t et{zoom, defproj};
+    expire_centroids(&et, generate_random(zoom, 100));
+    REQUIRE_FALSE(et.empty());
+
+    et.clear();
+    CHECK(et.empty());
+    CHECK(get_tiles_unordered(&et, zoom).empty());
+}
+
 /**
  * The set union still works when we expire large contiguous areas of tiles
  * (i.e: ensure that we handle the "complete" flag correctly)
@@ -502,3 +564,25 @@ TEST_CASE("merge with complete flag", "[NoDB]")
 
     CHECK(set == set0);
 }
+
+/**
+ * Expiring the same tiles again and again (enough to trigger several
+ * compactions of the internal tile list) doesn't change the result.
+ */
+TEST_CASE("expire same tiles repeatedly", "[NoDB]")
+{
+    uint32_t const zoom = 18;
+
+    expire_tiles_t et{zoom, defproj};
+
+    auto const check_set = generate_random(zoom, 1000);
+    for (int i = 0; i < 10; ++i) {
+        expire_centroids(&et, check_set);
+    }
+
+    auto const tiles = et.get_tiles();
+    REQUIRE(tiles.size() == check_set.size());
+    CHECK(std::is_sorted(tiles.cbegin(), tiles.cend()));
+
+    CHECK(et.empty());
+}
@@ -0,0 +1,113 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "common-buffer.hpp"
+
+#include "flex-tag-filter.hpp"
+
+TEST_CASE("tag filter not enabled matches everything", "[NoDB]")
+{
+    test_buffer_t buffer;
+    auto const &node = buffer.add_node("n1 Tamenity=bench");
+
+    flex_tag_filter_t const filter;
+
+    REQUIRE_FALSE(filter.enabled(osmium::item_type::node));
+    REQUIRE(filter.matches(osmium::item_type::node, node.tags()));
+}
+
+TEST_CASE("tag filter enabled without patterns matches nothing", "[NoDB]")
+{
+    test_buffer_t buffer;
+    auto const &node = buffer.add_node("n1 Tamenity=bench");
+    auto const &way = buffer.add_way("w1 Thighway=primary Nn1,n2");
+
+    flex_tag_filter_t filter;
+    filter.enable(osmium::item_type::node);
+
+    REQUIRE(filter.enabled(osmium::item_type::node));
+    REQUIRE_FALSE(filter.matches(osmium::item_type::node, node.tags()));
+
+    REQUIRE_FALSE(filter.enabled(osmium::item_type::way));
+    REQUIRE(filter.matches(osmium::item_type::way, way.tags()));
+}
+
+TEST_CASE("tag filter with keys", "[NoDB]")
+{
+    test_buffer_t buffer;
+    auto const &n1 = buffer.add_node("n1 Tamenity=bench");
+    auto const &n2 = buffer.add_node("n2 Tname=Foo,shop=bakery");
+    auto const &n3 = buffer.add_node("n3 Tcreated_by=JOSM");
+
+    flex_tag_filter_t filter;
+    filter.add(osmium::item_type::node, "amenity");
+    filter.add(osmium::item_type::node, "shop");
+
+    REQUIRE(filter.num_patterns(osmium::item_type::node) == 2);
+    REQUIRE(filter.matches(osmium::item_type::node, n1.tags()));
+    REQUIRE(filter.matches(osmium::item_type::node, n2.tags()));
+    REQUIRE_FALSE(filter.matches(osmium::item_type::node, n3.tags()));
+}
+
+TEST_CASE("tag filter with keys and values", "[NoDB]")
+{
+    test_buffer_t buffer;
+    auto const &n1 = buffer.add_node("n1 Thighway=traffic_signals");
+    auto const &n2 = buffer.add_node("n2 Thighway=crossing");
+    auto const &n3 = buffer.add_node("n3 Trailway=level_crossing");
+
+    flex_tag_filter_t filter;
+    filter.add(osmium::item_type::node, "highway=traffic_signals");
+    filter.add(osmium::item_type::node, "railway=*crossing");
+
+    REQUIRE(filter.matches(osmium::item_type::node, n1.tags()));
+    REQUIRE_FALSE(filter.matches(osmium::item_type::node, n2.tags()));
+    REQUIRE(filter.matches(osmium::item_type::node, n3.tags()));
+}
+
+TEST_CASE("tag filter with wildcard keys", "[NoDB]")
+{
+    test_buffer_t buffer;
+    auto const &n1 = buffer.add_node("n1 Taddr:street=Main");
+    auto const &n2 = buffer.add_node("n2 Taddr=yes");
+    auto const &n3 = buffer.add_node("n3 Tname:de=Foo");
+    auto const &n4 = buffer.add_node("n4 Tname:fr=Foo");
+
+    flex_tag_filter_t filter;
+    filter.add(osmium::item_type::node, "addr:*");
+    filter.add(osmium::item_type::node, "name:??=Foo");
+
+    REQUIRE(filter.matches(osmium::item_type::node, n1.tags()));
+    REQUIRE_FALSE(filter.matches(osmium::item_type::node, n2.tags()));
+    REQUIRE(filter.matches(osmium::item_type::node, n3.tags()));
+    REQUIRE(filter.matches(osmium::item_type::node, n4.tags()));
+}
+
+TEST_CASE("tag filter with empty value", "[NoDB]")
+{
+    test_buffer_t buffer;
+    auto const &n1 = buffer.add_node("n1 Tnote=");
+    auto const &n2 = buffer.add_node("n2 Tnote=foo");
+
+    flex_tag_filter_t filter;
+    filter.add(osmium::item_type::node, "note=");
+
+    REQUIRE(filter.matches(osmium::item_type::node, n1.tags()));
+    REQUIRE_FALSE(filter.matches(osmium::item_type::node, n2.tags()));
+}
+
+TEST_CASE("tag filter patterns need a key", "[NoDB]")
+{
+    flex_tag_filter_t filter;
+
+    REQUIRE_THROWS(filter.add(osmium::item_type::node, ""));
+    REQUIRE_THROWS(filter.add(osmium::item_type::way, "=foo"));
+}
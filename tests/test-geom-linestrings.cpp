@@ -59,6 +59,14 @@ TEST_CASE("line geometry", "[NoDB]")
     REQUIRE(geometry_type(geom) == "LINESTRING");
     REQUIRE(centroid(geom) == geom::geometry_t{geom::point_t{1.5, 1.5}});
     REQUIRE(geometry_n(geom, 1) == geom);
+    REQUIRE(is_valid(geom));
+}
+
+TEST_CASE("line geometry with a single distinct point is invalid", "[NoDB]")
+{
+    geom::geometry_t const geom{geom::linestring_t{{1, 1}, {1, 1}}};
+
+    REQUIRE_FALSE(is_valid(geom));
 }
 
 TEST_CASE("reverse line geometry", "[NoDB]")
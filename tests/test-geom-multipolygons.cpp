@@ -61,6 +61,21 @@ TEST_CASE("multipolygon geometry with two polygons", "[NoDB]")
     REQUIRE(area(geom) == Approx(9.0));
     REQUIRE(spherical_area(geom) == Approx(111106540105.7));
     REQUIRE(length(geom) == Approx(0.0));
+    REQUIRE(is_valid(geom));
+}
+
+TEST_CASE("multipolygon with overlapping polygons is invalid", "[NoDB]")
+{
+    geom::geometry_t geom{geom::multipolygon_t{}};
+    auto &mp = geom.get<geom::multipolygon_t>();
+
+    // MULTIPOLYGON(((0 0, 0 2, 2 2, 2 0, 0 0)), ((1 1, 1 3, 3 3, 3 1, 1 1)))
+    mp.add_geometry(
+        geom::polygon_t{geom::ring_t{{0, 0}, {0, 2}, {2, 2}, {2, 0}, {0, 0}}});
+    mp.add_geometry(
+        geom::polygon_t{geom::ring_t{{1, 1}, {1, 3}, {3, 3}, {3, 1}, {1, 1}}});
+
+    REQUIRE_FALSE(is_valid(geom));
 }
 
 TEST_CASE("create_multipolygon creates simple polygon from OSM data", "[NoDB]")
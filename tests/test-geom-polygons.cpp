@@ -30,6 +30,7 @@ TEST_CASE("polygon geometry without inner", "[NoDB]")
     REQUIRE(geometry_type(geom) == "POLYGON");
     REQUIRE(centroid(geom) == geom::geometry_t{geom::point_t{0.5, 0.5}});
     REQUIRE(geometry_n(geom, 1) == geom);
+    REQUIRE(is_valid(geom));
 }
 
 TEST_CASE("polygon geometry without inner (reverse)", "[NoDB]")
@@ -45,6 +46,36 @@ TEST_CASE("polygon geometry without inner (reverse)", "[NoDB]")
     REQUIRE(length(geom) == Approx(0.0));
     REQUIRE(geometry_type(geom) == "POLYGON");
     REQUIRE(centroid(geom) == geom::geometry_t{geom::point_t{0.5, 0.5}});
+    REQUIRE(is_valid(geom));
+}
+
+TEST_CASE("self-intersecting polygon is invalid", "[NoDB]")
+{
+    // POLYGON((1 1, 1 2, 2 1, 2 2, 1 1))
+    geom::geometry_t const geom{
+        geom::polygon_t{geom::ring_t{{1, 1}, {1, 2}, {2, 1}, {2, 2}, {1, 1}}}};
+
+    REQUIRE_FALSE(is_valid(geom));
+}
+
+TEST_CASE("polygon with inner ring outside outer ring is invalid", "[NoDB]")
+{
+    // POLYGON((0 0, 0 1, 1 1, 1 0, 0 0), (2 2, 3 2, 3 3, 2 3, 2 2))
+    geom::polygon_t polygon{
+        geom::ring_t{{0, 0}, {0, 1}, {1, 1}, {1, 0}, {0, 0}}};
+    polygon.add_inner_ring(
+        geom::ring_t{{2, 2}, {3, 2}, {3, 3}, {2, 3}, {2, 2}});
+
+    REQUIRE_FALSE(is_valid(geom::geometry_t{std::move(polygon)}));
+}
+
+TEST_CASE("polygon with spike is invalid", "[NoDB]")
+{
+    // POLYGON((0 0, 0 1, 1 1, 2 1, 1 1, 1 0, 0 0))
+    geom::geometry_t const geom{geom::polygon_t{
+        geom::ring_t{{0, 0}, {0, 1}, {1, 1}, {2, 1}, {1, 1}, {1, 0}, {0, 0}}}};
+
+    REQUIRE_FALSE(is_valid(geom));
 }
 
 TEST_CASE("geom::polygon_t", "[NoDB]")
@@ -253,3 +253,77 @@ TEST_CASE("Transform geom::collection_t", "[NoDB]")
     check(rc3[0], geom::point_t{X55, Y44});
     check(rc3[1], geom::point_t{X33, Y22});
 }
+
+TEST_CASE("Transform into existing geometry reuses it", "[NoDB]")
+{
+    auto const &reprojection =
+        reprojection_t::create_projection(PROJ_SPHERE_MERC);
+
+    geom::geometry_t big{geom::multipolygon_t{}};
+    {
+        auto &mp = big.get<geom::multipolygon_t>();
+        for (int i = 0; i < 3; ++i) {
+            auto &polygon = mp.add_geometry();
+            polygon.outer() = {{0, 0}, {0, 3}, {3, 3}, {3, 0}, {0, 0}};
+            polygon.add_inner_ring(
+                geom::ring_t{{1, 1}, {2, 1}, {2, 2}, {1, 2}, {1, 1}});
+        }
+    }
+
+    geom::geometry_t small{geom::multipolygon_t{}};
+    {
+        auto &polygon = small.get<geom::multipolygon_t>().add_geometry(
+            geom::polygon_t{
+                geom::ring_t{{0, 0}, {0, 1}, {1, 1}, {1, 0}, {0, 0}}});
+        polygon.add_inner_ring(geom::ring_t{
+            {0.2, 0.2}, {0.8, 0.2}, {0.8, 0.8}, {0.2, 0.2}});
+    }
+
+    geom::geometry_t line{geom::linestring_t{{0.0, 0.0}, {5.5, 4.4}}};
+    geom::geometry_t long_line{
+        geom::linestring_t{{0.0, 0.0}, {1.0, 1.0}, {2.0, 1.0}, {5.5, 4.4}}};
+
+    geom::geometry_t result;
+    geom::transform(&result, big, *reprojection);
+    REQUIRE(result == geom::transform(big, *reprojection));
+
+    auto const &result_mp = result.get<geom::multipolygon_t>();
+    auto const *const polygon_data = &result_mp[0];
+    auto const *const outer_data = result_mp[0].outer().data();
+    auto const outer_capacity = result_mp[0].outer().capacity();
+    auto const *const inner_data = result_mp[0].inners()[0].data();
+    auto const inner_capacity = result_mp[0].inners()[0].capacity();
+
+    geom::transform(&result, small, *reprojection);
+    REQUIRE(result == geom::transform(small, *reprojection));
+
+    // The smaller geometry was written into the memory already allocated.
+    REQUIRE(&result_mp[0] == polygon_data);
+    REQUIRE(result_mp[0].outer().data() == outer_data);
+    REQUIRE(result_mp[0].outer().capacity() == outer_capacity);
+    REQUIRE(result_mp[0].inners()[0].data() == inner_data);
+    REQUIRE(result_mp[0].inners()[0].capacity() == inner_capacity);
+
+    geom::transform(&result, long_line, *reprojection);
+    REQUIRE(result == geom::transform(long_line, *reprojection));
+
+    auto const &result_line = result.get<geom::linestring_t>();
+    auto const *const line_data = result_line.data();
+    auto const line_capacity = result_line.capacity();
+
+    geom::transform(&result, line, *reprojection);
+    REQUIRE(result == geom::transform(line, *reprojection));
+
+    REQUIRE(result_line.data() == line_data);
+    REQUIRE(result_line.capacity() == line_capacity);
+
+    geom::geometry_t collection{geom::collection_t{}};
+    collection.get<geom::collection_t>().add_geometry(std::move(line));
+    collection.get<geom::collection_t>().add_geometry(std::move(big));
+
+    geom::transform(&result, collection, *reprojection);
+    REQUIRE(result == geom::transform(collection, *reprojection));
+
+    geom::transform(&result, small, *reprojection);
+    REQUIRE(result == geom::transform(small, *reprojection));
+}
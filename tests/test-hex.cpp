@@ -7,10 +7,13 @@
  * For a full list of authors see the git log.
  */
 
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch.hpp>
 
+#include "format.hpp"
 #include "hex.hpp"
 
+#include <cstddef>
 #include <string>
 
 TEST_CASE("hex encode a string", "[NoDB]")
@@ -84,3 +87,69 @@ TEST_CASE("hex encode and decode") {
     std::string const str{"something somewhere"};
     REQUIRE(util::decode_hex(util::encode_hex(str)) == str);
 }
+
+TEST_CASE("hex encode and decode all byte values in long strings")
+{
+    std::string data;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        data += static_cast<char>(i % 256);
+    }
+
+    // Different lengths and offsets to test vectorized code and remainder.
+    for (std::size_t len : {15, 16, 17, 31, 32, 33, 256, 1000}) {
+        std::string const str = data.substr(1000 - len);
+        std::string hex{"x"};
+        util::encode_hex(str, &hex);
+        REQUIRE(hex.size() == len * 2 + 1);
+        REQUIRE(hex[0] == 'x');
+
+        std::string expected{"x"};
+        for (char const c : str) {
+            expected += fmt::format("{:02X}", static_cast<unsigned char>(c));
+        }
+        REQUIRE(hex == expected);
+
+        REQUIRE(util::decode_hex(hex.substr(1)) == str);
+    }
+}
+
+TEST_CASE("hex decode of long string with lower case and invalid characters")
+{
+    std::string const hex{"0123456789abcdefABCDEF#@gG:/`\x7f\x80\xff"
+                          "0123456789abcdefABCDEF#@gG:/`\x7f\x80\xff"};
+    REQUIRE(hex.size() == 64);
+
+    auto const result = util::decode_hex(hex);
+    REQUIRE(result.size() == 32);
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        unsigned int const expected =
+            (util::decode_hex_char(hex[i * 2]) << 4U) |
+            util::decode_hex_char(hex[i * 2 + 1]);
+        REQUIRE(static_cast<unsigned char>(result[i]) == expected);
+    }
+}
+
+// Benchmarks are not run by default, use "test-hex [benchmark]" to run them.
+TEST_CASE("hex encode and decode benchmark", "[.][benchmark]")
+{
+    // Typical sizes of WKB for points, short lines, and larger polygons.
+    for (std::size_t const size : {21, 200, 4000, 100000}) {
+        std::string data;
+        for (std::size_t i = 0; i < size; ++i) {
+            data += static_cast<char>(i * 7);
+        }
+        std::string const hex = util::encode_hex(data);
+
+        BENCHMARK("encode_hex " + std::to_string(size) + " bytes")
+        {
+            std::string out;
+            util::encode_hex(data, &out);
+            return out;
+        };
+
+        BENCHMARK("decode_hex " + std::to_string(size) + " bytes")
+        {
+            return util::decode_hex(hex);
+        };
+    }
+}
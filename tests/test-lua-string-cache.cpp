@@ -0,0 +1,110 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "lua-string-cache.hpp"
+
+#include <lua.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace {
+
+std::shared_ptr<lua_State> new_lua_state()
+{
+    return {luaL_newstate(), [](lua_State *state) { lua_close(state); }};
+}
+
+std::string pop_string(lua_State *lua_state)
+{
+    REQUIRE(lua_type(lua_state, -1) == LUA_TSTRING);
+    std::string result{lua_tostring(lua_state, -1)};
+    lua_pop(lua_state, 1);
+    return result;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Strings pushed through the cache end up on the stack", "[NoDB]")
+{
+    auto const lua_state = new_lua_state();
+    lua_string_cache_t cache;
+
+    cache.push(lua_state.get(), "highway");
+    cache.push(lua_state.get(), "highway");
+    cache.push(lua_state.get(), "name");
+    REQUIRE(lua_gettop(lua_state.get()) == 3);
+
+    REQUIRE(pop_string(lua_state.get()) == "name");
+    REQUIRE(pop_string(lua_state.get()) == "highway");
+    REQUIRE(pop_string(lua_state.get()) == "highway");
+
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 2);
+}
+
+TEST_CASE("Empty and long strings are not cached", "[NoDB]")
+{
+    auto const lua_state = new_lua_state();
+    lua_string_cache_t cache;
+
+    std::string const long_str(lua_string_cache_t::MAX_LENGTH + 1, 'x');
+
+    for (int i = 0; i < 2; ++i) {
+        cache.push(lua_state.get(), "");
+        REQUIRE(pop_string(lua_state.get()).empty());
+        cache.push(lua_state.get(), long_str.c_str());
+        REQUIRE(pop_string(lua_state.get()) == long_str);
+    }
+
+    REQUIRE(cache.hits() == 0);
+    REQUIRE(cache.misses() == 0);
+}
+
+TEST_CASE("Frequent strings are not replaced by rare ones", "[NoDB]")
+{
+    auto const lua_state = new_lua_state();
+    lua_string_cache_t cache;
+
+    // These two strings only differ in a character not used for finding
+    // the slot, so they end up in the same slot.
+    char const *const frequent = "abcd";
+    char const *const rare = "axcd";
+
+    for (int i = 0; i < 5; ++i) {
+        cache.push(lua_state.get(), frequent);
+        REQUIRE(pop_string(lua_state.get()) == frequent);
+    }
+    REQUIRE(cache.hits() == 4);
+    REQUIRE(cache.misses() == 1);
+
+    // The rare string doesn't push out the frequent one...
+    cache.push(lua_state.get(), rare);
+    REQUIRE(pop_string(lua_state.get()) == rare);
+    cache.push(lua_state.get(), frequent);
+    REQUIRE(pop_string(lua_state.get()) == frequent);
+    REQUIRE(cache.hits() == 5);
+    REQUIRE(cache.misses() == 2);
+
+    // ...until it has been seen often enough.
+    for (uint32_t i = 0; i <= lua_string_cache_t::MAX_SCORE; ++i) {
+        cache.push(lua_state.get(), rare);
+        REQUIRE(pop_string(lua_state.get()) == rare);
+    }
+    auto const misses = cache.misses();
+    cache.push(lua_state.get(), rare);
+    REQUIRE(pop_string(lua_state.get()) == rare);
+    REQUIRE(cache.misses() == misses);
+    cache.push(lua_state.get(), frequent);
+    REQUIRE(pop_string(lua_state.get()) == frequent);
+    REQUIRE(cache.misses() == misses + 1);
+}
@@ -113,3 +113,25 @@ TEST_CASE("luaX_for_each should not call the function for empty arrays",
     });
     REQUIRE_FALSE(called);
 }
+
+TEST_CASE("luaX_dump_function result can be loaded into other Lua state",
+          "[NoDB]")
+{
+    std::shared_ptr<lua_State> lua_state{
+        luaL_newstate(), [](lua_State *state) { lua_close(state); }};
+
+    REQUIRE(luaL_loadstring(lua_state.get(),
+                            "local x = ... return x * 2 + 1") == 0);
+    auto const chunk = luaX_dump_function(lua_state.get());
+    REQUIRE(lua_gettop(lua_state.get()) == 1);
+    REQUIRE_FALSE(chunk.empty());
+
+    std::shared_ptr<lua_State> other_state{
+        luaL_newstate(), [](lua_State *state) { lua_close(state); }};
+
+    REQUIRE(luaL_loadbuffer(other_state.get(), chunk.data(), chunk.size(),
+                            "test") == 0);
+    lua_pushinteger(other_state.get(), 20);
+    REQUIRE(lua_pcall(other_state.get(), 1, 1, 0) == 0);
+    REQUIRE(lua_tointeger(other_state.get(), -1) == 41);
+}
@@ -211,3 +211,23 @@ TEST_CASE("Parsing log-progress fails for unknown value", "[NoDB]")
     bad_opt({"--log-progress", "foo"},
             "Unknown value for --log-progress option: ");
 }
+
+TEST_CASE("Parsing log-lua-profile", "[NoDB]")
+{
+    REQUIRE(opt({"-O", "flex", "--log-lua-profile", "calls"}).lua_profile ==
+            "calls");
+    REQUIRE(opt({"-O", "flex", "--log-lua-profile", "lines"}).lua_profile ==
+            "lines");
+    REQUIRE(opt({"-O", "flex"}).lua_profile.empty());
+}
+
+TEST_CASE("Parsing log-lua-profile fails for unknown value", "[NoDB]")
+{
+    bad_opt({"-O", "flex", "--log-lua-profile", "foo"},
+            "--log-lua-profile: foo not in");
+}
+
+TEST_CASE("Option log-lua-profile is ignored without flex output", "[NoDB]")
+{
+    REQUIRE(opt({"--log-lua-profile", "calls"}).lua_profile.empty());
+}
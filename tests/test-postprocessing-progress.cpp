@@ -0,0 +1,81 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "common-pg.hpp"
+
+#include "pgsql.hpp"
+#include "postprocessing-progress.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+testing::pg::tempdb_t db;
+
+} // anonymous namespace
+
+TEST_CASE("No time left estimate without progress")
+{
+    REQUIRE(estimate_seconds_left(0.2, 0.2, 10.0) < 0.0);
+    REQUIRE(estimate_seconds_left(0.5, 0.2, 10.0) < 0.0);
+    REQUIRE(estimate_seconds_left(0.0, 0.2, 0.0) < 0.0);
+}
+
+TEST_CASE("Time left estimate")
+{
+    REQUIRE(estimate_seconds_left(0.0, 0.5, 10.0) == Approx(10.0));
+    REQUIRE(estimate_seconds_left(0.2, 0.4, 10.0) == Approx(30.0));
+    REQUIRE(estimate_seconds_left(0.0, 1.0, 10.0) == Approx(0.0));
+}
+
+TEST_CASE("Stopping progress reporting without database works")
+{
+    connection_params_t connection_params;
+    connection_params.set("dbname", "osm2pgsql-does-not-exist");
+
+    postprocessing_progress_t progress{connection_params,
+                                       std::chrono::seconds{1}};
+    progress.stop();
+    progress.stop();
+}
+
+TEST_CASE("Progress reports active queries from osm2pgsql connections")
+{
+    postprocessing_progress_t progress{db.connection_params(),
+                                       std::chrono::seconds{3600}};
+
+    pg_conn_t const conn{db.connection_params(), "check"};
+    REQUIRE(progress.collect(conn).empty());
+
+    std::thread sleeper{[] {
+        pg_conn_t const sleep_conn{db.connection_params(), "index"};
+        sleep_conn.exec("SELECT pg_sleep(2)");
+    }};
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < 50 && messages.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        messages = progress.collect(conn);
+    }
+
+    sleeper.join();
+
+    REQUIRE(messages.size() == 1);
+    REQUIRE(messages[0].find("osm2pgsql.index/C") == 0);
+    REQUIRE(messages[0].find("SELECT pg_sleep(2)") != std::string::npos);
+
+    REQUIRE(progress.collect(conn).empty());
+
+    progress.stop();
+}
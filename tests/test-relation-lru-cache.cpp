@@ -0,0 +1,123 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "common-buffer.hpp"
+
+#include "relation-lru-cache.hpp"
+
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+
+namespace {
+
+osmium::memory::Buffer new_buffer()
+{
+    return osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+}
+
+void add_to_cache(relation_lru_cache_t *cache, osmid_t id)
+{
+    test_buffer_t relation;
+    relation.add_relation(
+        fmt::format("r{} Ttype=multipolygon Mw{}@outer", id, id + 1000));
+
+    test_buffer_t members;
+    members.add_way(fmt::format("w{} Nn1x1y1,n2x2y2,n3x3y3", id + 1000));
+
+    cache->add(id, relation.buffer(), members.buffer());
+}
+
+bool in_cache(relation_lru_cache_t *cache, osmid_t id)
+{
+    auto relation_buffer = new_buffer();
+    auto members_buffer = new_buffer();
+    return cache->get(id, &relation_buffer, &members_buffer);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Relation and members can be read back from the cache", "[NoDB]")
+{
+    relation_lru_cache_t cache{1024UL * 1024UL};
+
+    add_to_cache(&cache, 17);
+    REQUIRE(cache.size() == 1);
+
+    auto relation_buffer = new_buffer();
+    auto members_buffer = new_buffer();
+    REQUIRE(cache.get(17, &relation_buffer, &members_buffer));
+
+    auto const &relation = relation_buffer.get<osmium::Relation>(0);
+    REQUIRE(relation.id() == 17);
+    REQUIRE(std::string{relation.tags()["type"]} == "multipolygon");
+    REQUIRE(relation.members().size() == 1);
+
+    auto const &way = members_buffer.get<osmium::Way>(0);
+    REQUIRE(way.id() == 1017);
+    REQUIRE(way.nodes().size() == 3);
+    REQUIRE(way.nodes()[1].location() == osmium::Location{2.0, 2.0});
+
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 0);
+}
+
+TEST_CASE("Unknown relations are not found in the cache", "[NoDB]")
+{
+    relation_lru_cache_t cache{1024UL * 1024UL};
+
+    add_to_cache(&cache, 17);
+
+    auto relation_buffer = new_buffer();
+    auto members_buffer = new_buffer();
+    REQUIRE_FALSE(cache.get(18, &relation_buffer, &members_buffer));
+    REQUIRE(relation_buffer.committed() == 0);
+    REQUIRE(members_buffer.committed() == 0);
+
+    REQUIRE(cache.hits() == 0);
+    REQUIRE(cache.misses() == 1);
+}
+
+TEST_CASE("Relations too large for the cache are not added", "[NoDB]")
+{
+    relation_lru_cache_t cache{16};
+
+    add_to_cache(&cache, 17);
+    REQUIRE(cache.size() == 0);
+    REQUIRE_FALSE(in_cache(&cache, 17));
+}
+
+TEST_CASE("Least recently used relations are removed first", "[NoDB]")
+{
+    relation_lru_cache_t cache{4096};
+
+    add_to_cache(&cache, 1);
+    add_to_cache(&cache, 2);
+
+    // Add relations until the cache is full and starts removing entries,
+    // always using relation 1 so that it is never the least recently used.
+    osmid_t id = 3;
+    std::size_t size = cache.size();
+    while (true) {
+        REQUIRE(in_cache(&cache, 1));
+        add_to_cache(&cache, id);
+        if (cache.size() <= size) {
+            break;
+        }
+        size = cache.size();
+        ++id;
+    }
+
+    REQUIRE(in_cache(&cache, 1));
+    REQUIRE_FALSE(in_cache(&cache, 2));
+    REQUIRE(in_cache(&cache, id));
+}
@@ -12,6 +12,37 @@
 #include "projection.hpp"
 #include "reprojection.hpp"
 
+#include <vector>
+
+namespace {
+
+/**
+ * Check that reproject_points() gives the same results as reproject() for
+ * lots of points on a line between the given corners.
+ */
+void check_reproject_points(int srs, geom::point_t from, geom::point_t to)
+{
+    auto const reprojection = reprojection_t::create_projection(srs);
+
+    std::vector<geom::point_t> points;
+    for (int i = 0; i <= 500; ++i) {
+        points.emplace_back(from.x() + ((to.x() - from.x()) * i / 500.0),
+                            from.y() + ((to.y() - from.y()) * i / 500.0));
+    }
+
+    auto projected = points;
+    reprojection->reproject_points(projected.data(), projected.size());
+
+    REQUIRE(projected.size() == points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        auto const c = reprojection->reproject(points[i]);
+        REQUIRE(projected[i].x() == Approx(c.x()));
+        REQUIRE(projected[i].y() == Approx(c.y()));
+    }
+}
+
+} // anonymous namespace
+
 TEST_CASE("projection 4326", "[NoDB]")
 {
     osmium::Location const loc{10.0, 53.0};
@@ -85,6 +116,18 @@ TEST_CASE("projection 3857 bounds", "[NoDB]")
     }
 }
 
+TEST_CASE("reproject points in batch 4326", "[NoDB]")
+{
+    check_reproject_points(PROJ_LATLONG, {-180.0, -90.0}, {180.0, 90.0});
+}
+
+TEST_CASE("reproject points in batch 3857", "[NoDB]")
+{
+    // Latitudes cover the whole range including the ones outside the
+    // Mercator bounds.
+    check_reproject_points(PROJ_SPHERE_MERC, {-180.0, -90.0}, {180.0, 90.0});
+}
+
 #ifdef HAVE_GENERIC_PROJ
 TEST_CASE("projection 5651", "[NoDB]")
 {
@@ -103,4 +146,9 @@ TEST_CASE("projection 5651", "[NoDB]")
     REQUIRE(ct.x() == Approx(1113194.91));
     REQUIRE(ct.y() == Approx(6982997.92));
 }
+
+TEST_CASE("reproject points in batch 5651", "[NoDB]")
+{
+    check_reproject_points(5651, {0.0, 45.0}, {6.0, 60.0});
+}
 #endif
@@ -0,0 +1,109 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "row-sorter.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> drain(row_sorter_t *sorter)
+{
+    std::vector<std::string> rows;
+    sorter->drain([&](quadkey_t /*key*/, std::string_view row) {
+        rows.emplace_back(row);
+    });
+    return rows;
+}
+
+} // anonymous namespace
+
+TEST_CASE("empty row sorter", "[NoDB]")
+{
+    row_sorter_t sorter;
+    REQUIRE(sorter.empty());
+    REQUIRE(drain(&sorter).empty());
+}
+
+TEST_CASE("row sorter in memory", "[NoDB]")
+{
+    row_sorter_t sorter;
+
+    sorter.add(quadkey_t{3}, "c\n");
+    sorter.add(quadkey_t{1}, "a\n");
+    sorter.add(quadkey_t{2}, "b1\n");
+    sorter.add(quadkey_t{2}, "b2\n");
+    sorter.add(quadkey_t{}, "null\n");
+
+    REQUIRE(sorter.size() == 5);
+    REQUIRE(sorter.num_runs() == 0);
+
+    auto const rows = drain(&sorter);
+    REQUIRE(rows ==
+            std::vector<std::string>{"a\n", "b1\n", "b2\n", "c\n", "null\n"});
+    REQUIRE(sorter.empty());
+}
+
+TEST_CASE("row sorter returns keys with rows", "[NoDB]")
+{
+    row_sorter_t sorter;
+
+    sorter.add(quadkey_t{7}, "x\n");
+    sorter.add(quadkey_t{5}, "y\n");
+
+    std::vector<uint64_t> keys;
+    sorter.drain([&](quadkey_t key, std::string_view /*row*/) {
+        keys.push_back(key.value());
+    });
+    REQUIRE(keys == std::vector<uint64_t>{5, 7});
+}
+
+TEST_CASE("row sorter with runs in temporary files", "[NoDB]")
+{
+    // Use a tiny amount of memory so that many runs are written
+    row_sorter_t sorter{1000};
+
+    // NOLINTNEXTLINE(cert-msc32-c,cert-msc51-cpp)
+    std::mt19937_64 rng{47382};
+    std::uniform_int_distribution<uint64_t> dist{0, 100};
+
+    for (int i = 0; i < 1000; ++i) {
+        auto const key = dist(rng);
+        sorter.add(quadkey_t{key}, std::to_string(key) + "-" +
+                                       std::to_string(i) + "\n");
+    }
+
+    REQUIRE(sorter.size() == 1000);
+    REQUIRE(sorter.num_runs() > 1);
+
+    auto const rows = drain(&sorter);
+    REQUIRE(rows.size() == 1000);
+
+    uint64_t last_key = 0;
+    int last_num = -1;
+    for (auto const &row : rows) {
+        auto const pos = row.find('-');
+        auto const key = std::stoull(row.substr(0, pos));
+        auto const num = std::stoi(row.substr(pos + 1));
+        REQUIRE(key >= last_key);
+        if (key == last_key) {
+            // rows with the same key keep their order
+            REQUIRE(num > last_num);
+        }
+        last_key = key;
+        last_num = num;
+    }
+
+    REQUIRE(sorter.empty());
+    REQUIRE(sorter.num_runs() == 0);
+}
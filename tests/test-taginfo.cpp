@@ -30,3 +30,92 @@ TEST_CASE("parse_tag_flags", "[NoDB]")
     CHECK(parse_tag_flags("polygon, nocache,delete", 0) ==
           (FLAG_POLYGON | FLAG_DELETE));
 }
+
+namespace {
+
+taginfo make_info(char const *name, unsigned int flags)
+{
+    taginfo info;
+    info.name = name;
+    info.type = "text";
+    info.flags = flags;
+    return info;
+}
+
+} // anonymous namespace
+
+TEST_CASE("export_key_index_t with empty list", "[NoDB]")
+{
+    export_key_index_t const index{std::vector<taginfo>{}};
+    unsigned int flags = 0;
+    CHECK(index.find("highway", &flags) == export_key_index_t::result::unknown);
+    CHECK(flags == 0);
+
+    export_key_index_t const default_index;
+    CHECK(default_index.find("highway", &flags) ==
+          export_key_index_t::result::unknown);
+}
+
+TEST_CASE("export_key_index_t finds keys", "[NoDB]")
+{
+    std::vector<taginfo> const infos = {
+        make_info("note", FLAG_DELETE), make_info("source:*", FLAG_DELETE),
+        make_info("highway", FLAG_LINEAR), make_info("building", FLAG_POLYGON),
+        make_info("name", 0), make_info("highway", FLAG_POLYGON)};
+    export_key_index_t const index{infos};
+
+    unsigned int flags = 0;
+    CHECK(index.find("highway", &flags) == export_key_index_t::result::keep);
+    CHECK(flags == FLAG_LINEAR);
+    CHECK(index.find("building", &flags) == export_key_index_t::result::keep);
+    CHECK(flags == (FLAG_LINEAR | FLAG_POLYGON));
+
+    flags = 0;
+    CHECK(index.find("name", &flags) == export_key_index_t::result::keep);
+    CHECK(flags == 0);
+    CHECK(index.find("note", &flags) == export_key_index_t::result::drop);
+    CHECK(index.find("source:name", &flags) ==
+          export_key_index_t::result::drop);
+    CHECK(index.find("source", &flags) == export_key_index_t::result::unknown);
+    CHECK(index.find("highwa", &flags) == export_key_index_t::result::unknown);
+    CHECK(index.find("", &flags) == export_key_index_t::result::unknown);
+    CHECK(flags == 0);
+}
+
+TEST_CASE("export_key_index_t respects order of entries", "[NoDB]")
+{
+    std::vector<taginfo> const infos = {
+        make_info("name", 0), make_info("*", FLAG_DELETE),
+        make_info("highway", FLAG_LINEAR), make_info("ref", FLAG_DELETE),
+        make_info("ref", 0)};
+    export_key_index_t const index{infos};
+
+    unsigned int flags = 0;
+    CHECK(index.find("name", &flags) == export_key_index_t::result::keep);
+    CHECK(index.find("highway", &flags) == export_key_index_t::result::drop);
+    CHECK(index.find("ref", &flags) == export_key_index_t::result::drop);
+    CHECK(index.find("foo", &flags) == export_key_index_t::result::drop);
+}
+
+TEST_CASE("export_key_index_t with many keys", "[NoDB]")
+{
+    std::vector<taginfo> infos;
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("key" + std::to_string(i));
+        infos.push_back(make_info(names.back().c_str(), i % 2 ? FLAG_DELETE
+                                                              : FLAG_LINEAR));
+    }
+    export_key_index_t const index{infos};
+
+    for (int i = 0; i < 1000; ++i) {
+        unsigned int flags = 0;
+        CHECK(index.find(names[i].c_str(), &flags) ==
+              (i % 2 ? export_key_index_t::result::drop
+                     : export_key_index_t::result::keep));
+    }
+
+    unsigned int flags = 0;
+    CHECK(index.find("key1000", &flags) ==
+          export_key_index_t::result::unknown);
+}
@@ -0,0 +1,129 @@
+/**
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This file is part of osm2pgsql (https://osm2pgsql.org/).
+ *
+ * Copyright (C) 2006-2025 by the osm2pgsql developer community.
+ * For a full list of authors see the git log.
+ */
+
+#include <catch.hpp>
+
+#include "thread-pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Thread pool runs tasks and reports run time")
+{
+    thread_pool_t pool{2};
+    REQUIRE(pool.num_threads() == 2);
+
+    std::atomic<int> count{0};
+    task_result_t result;
+    result.set(pool.submit([&count]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        ++count;
+    }));
+
+    REQUIRE(result.runtime().count() == 0);
+
+    auto const run_time = result.wait();
+    REQUIRE(count == 1);
+    REQUIRE(run_time >= std::chrono::milliseconds{10});
+    REQUIRE(result.runtime() == run_time);
+
+    // waiting again returns the stored run time
+    REQUIRE(result.wait() == run_time);
+}
+
+TEST_CASE("Exception thrown in task is rethrown from wait()")
+{
+    thread_pool_t pool{1};
+
+    task_result_t result;
+    result.set(pool.submit([]() { throw std::runtime_error{"task failed"}; }));
+
+    REQUIRE_THROWS_WITH(result.wait(), "task failed");
+}
+
+TEST_CASE("Task can wait for other task using its future")
+{
+    thread_pool_t pool{2};
+
+    task_result_t first;
+    first.set(pool.submit([]() { throw std::runtime_error{"first failed"}; }));
+
+    task_result_t second;
+    second.set(pool.submit([future = first.future()]() { future.get(); }));
+
+    REQUIRE_THROWS_WITH(second.wait(), "first failed");
+    REQUIRE_THROWS_WITH(first.wait(), "first failed");
+}
+
+TEST_CASE("wait_for_tasks() sums up run times of all tasks")
+{
+    thread_pool_t pool{3};
+
+    std::atomic<int> count{0};
+    std::vector<task_result_t> tasks(5);
+    for (auto &task : tasks) {
+        task.set(pool.submit([&count]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+            ++count;
+        }));
+    }
+
+    auto const run_time = wait_for_tasks(&tasks);
+    REQUIRE(count == 5);
+    REQUIRE(run_time >= std::chrono::milliseconds{10});
+
+    std::chrono::microseconds sum{};
+    for (auto const &task : tasks) {
+        REQUIRE(task.runtime().count() > 0);
+        sum += task.runtime();
+    }
+    REQUIRE(run_time == sum);
+}
+
+TEST_CASE("wait_for_tasks() waits for all tasks and rethrows first exception")
+{
+    thread_pool_t pool{2};
+
+    std::atomic<int> count{0};
+    std::vector<task_result_t> tasks(6);
+
+    tasks[0].set(pool.submit([]() { throw std::runtime_error{"first"}; }));
+    tasks[1].set(pool.submit([&count]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        ++count;
+    }));
+    tasks[2].set(pool.submit([]() { throw std::runtime_error{"second"}; }));
+    for (std::size_t i = 3; i < tasks.size(); ++i) {
+        tasks[i].set(pool.submit([&count]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            ++count;
+        }));
+    }
+
+    REQUIRE_THROWS_WITH(wait_for_tasks(&tasks), "first");
+
+    // All tasks that didn't throw have finished and have their results
+    // collected.
+    REQUIRE(count == 4);
+    REQUIRE(tasks[0].runtime().count() == 0);
+    REQUIRE(tasks[1].runtime().count() > 0);
+    REQUIRE(tasks[2].runtime().count() == 0);
+    for (std::size_t i = 3; i < tasks.size(); ++i) {
+        REQUIRE(tasks[i].runtime().count() > 0);
+    }
+}
+
+TEST_CASE("wait_for_tasks() with no tasks")
+{
+    std::vector<task_result_t> tasks;
+    REQUIRE(wait_for_tasks(&tasks).count() == 0);
+}
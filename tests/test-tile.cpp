@@ -152,3 +152,20 @@ TEST_CASE("tile_t coordinates zoom=2", "[NoDB]")
     auto const q = tile.quadkey();
     REQUIRE(tile == tile_t::from_quadkey(q, tile.zoom()));
 }
+
+TEST_CASE("tile_t from point", "[NoDB]")
+{
+    REQUIRE(tile_t::from_point({0.0, 0.0}, 0) == tile_t(0, 0, 0));
+
+    tile_t const tile{2, 1, 2};
+    REQUIRE(tile_t::from_point(tile.center(), 2) == tile);
+    REQUIRE(tile_t::from_point(tile.center(), 1) == tile_t(1, 0, 1));
+
+    tile_t const tile18{18, 140221, 82055};
+    REQUIRE(tile_t::from_point(tile18.center(), 18) == tile18);
+
+    // Points outside the map are clamped
+    double const m = tile_t::EARTH_CIRCUMFERENCE;
+    REQUIRE(tile_t::from_point({-m, m}, 2) == tile_t(2, 0, 0));
+    REQUIRE(tile_t::from_point({m, -m}, 2) == tile_t(2, 3, 3));
+}